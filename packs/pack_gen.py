@@ -1,8 +1,9 @@
 import os
 import glob
 import struct
+import zlib
 
-FORMAT_VERSION = 0
+FORMAT_VERSION = 1
 
 def convertObj(filename):
 	f = open(filename, 'r')
@@ -61,12 +62,12 @@ def buildPack(name):
 	f.write(struct.pack('>i', len(files)))
 	offset = 8
 	for filename, data in files.items():
-		offset += 1 + len(filename) + 8
+		offset += 1 + len(filename) + 12
 	for filename, data in files.items():
 		f.write(struct.pack('>B', len(filename)))
 		f.write(filename)
 		flog.write(filename + '\n')
-		f.write(struct.pack('>ii', offset, len(data)))
+		f.write(struct.pack('>III', offset, len(data), zlib.crc32(data) & 0xffffffff))
 		print offset, filename
 		offset += len(data)
 	for filename, data in files.items():
@@ -0,0 +1,18 @@
+-- Name: Benchmark: fleet battle
+-- Description: 500 AI ships in two fleets fighting each other. Used by the EmptyEpsilonBench target to measure AI, weapons, physics and replication under load.
+-- Type: Development
+
+function init()
+    local templates = {"Adder MK5", "MT52 Hornet", "Phobos T3", "Piranha F12", "Stalker Q7", "Nirvana R5"}
+    local per_side = 250
+    for n = 1, per_side do
+        CpuShip():setTemplate(templates[irandom(1, #templates)]):setFaction("Human Navy")
+            :setPosition(random(-15000, -5000), random(-10000, 10000)):setRotation(0):orderRoaming()
+        CpuShip():setTemplate(templates[irandom(1, #templates)]):setFaction("Kraylor")
+            :setPosition(random(5000, 15000), random(-10000, 10000)):setRotation(180):orderRoaming()
+    end
+    for n = 1, 6 do
+        SpaceStation():setTemplate("Medium Station"):setFaction(n % 2 == 0 and "Human Navy" or "Kraylor")
+            :setPosition(n % 2 == 0 and -20000 or 20000, (n - 3.5) * 6000)
+    end
+end
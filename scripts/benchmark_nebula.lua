@@ -0,0 +1,18 @@
+-- Name: Benchmark: dense nebula field
+-- Description: A field of 300 nebulae with ships patrolling through it. Used by the EmptyEpsilonBench target to measure radar blocking and AI target searches inside nebulae.
+-- Type: Development
+
+function init()
+    for n = 1, 300 do
+        Nebula():setPosition(random(-40000, 40000), random(-40000, 40000))
+    end
+    for n = 1, 40 do
+        Asteroid():setPosition(random(-40000, 40000), random(-40000, 40000))
+    end
+    local factions = {"Human Navy", "Kraylor", "Exuari", "Independent"}
+    for n = 1, 120 do
+        local x, y = random(-40000, 40000), random(-40000, 40000)
+        CpuShip():setTemplate("Adder MK5"):setFaction(factions[irandom(1, #factions)])
+            :setPosition(x, y):orderFlyTowards(-x, -y)
+    end
+end
@@ -72,11 +72,7 @@ void ShipAI::run(float delta)
         warp->request = 0;
 
     // Update ranges before calculating
-    if (auto lrr = owner.getComponent<LongRangeRadar>()) {
-        long_range = lrr->long_range;
-        relay_range = long_range * 2.0f;
-        short_range = lrr->short_range;
-    }
+    updateRanges();
 
     updateWeaponState(delta);
     if (update_target_delay > 0.0f)
@@ -96,6 +92,131 @@ void ShipAI::run(float delta)
     }
 }
 
+// Copy of what the think phase needs to know about possible targets, taken on the main thread by prepareThinkTargets,
+// so the think phase never touches the components or the physics world from a worker thread.
+struct ThinkTarget
+{
+    sp::ecs::Entity entity;
+    glm::vec2 position;
+    uint8_t faction_index;
+    float score_bonus;
+    bool radar_link;
+    bool never_radar_blocked;
+};
+static std::vector<ThinkTarget> think_targets;
+
+static float targetScoreBonus(sp::ecs::Entity target)
+{
+    float bonus = 0.0f;
+    if (target.hasComponent<BeamWeaponSys>())
+        bonus += 2500;
+    if (target.hasComponent<MissileTubes>())
+        bonus += 2500;
+    if (target.hasComponent<DockingBay>())
+        bonus -= 1500;
+    return bonus;
+}
+
+void ShipAI::prepareThinkTargets()
+{
+    Faction::updateRelationMatrix();
+    think_targets.clear();
+    // Only what the queryArea in searchBestTarget can return: entities with a hull and a physics body.
+    for(auto [entity, hull, transform] : sp::ecs::Query<Hull, sp::Transform>())
+    {
+        if (!entity.hasComponent<sp::Physics>())
+            continue;
+        think_targets.push_back({entity, transform.getPosition(), Faction::getMatrixIndex(entity), targetScoreBonus(entity),
+            entity.hasComponent<AllowRadarLink>(), entity.hasComponent<NeverRadarBlocked>()});
+    }
+}
+
+void ShipAI::prepareThink()
+{
+    planned_target_search_count = 0;
+    updateRanges();
+
+    auto ot = owner.getComponent<sp::Transform>();
+    auto ai = owner.getComponent<AIController>();
+    if (!ot || !ai) return;
+    auto position = ot->getPosition();
+    auto target_component = owner.getComponent<Target>();
+
+    auto thrusters = owner.getComponent<ManeuveringThrusters>();
+    auto impulse = owner.getComponent<ImpulseEngine>();
+    think_owner = {position, ot->getRotation(), thrusters ? thrusters->speed : 10.0f, impulse ? impulse->max_speed_forward : 0.0f, has_missiles, beam_weapon_range, nullptr};
+    think_beams.clear();
+    if (auto beamsystem = owner.getComponent<BeamWeaponSys>())
+    {
+        for(auto& mount : beamsystem->mounts)
+            think_beams.push_back({mount.range, mount.direction, mount.arc});
+        think_owner.mounts = &think_beams;
+    }
+    think_faction_index = Faction::getMatrixIndex(owner);
+
+    // Mirror the searches done by updateTarget, using the weapon state of the previous run.
+    if (update_target_delay <= 0.0f)
+    {
+        sp::ecs::Entity target = target_component ? target_component->entity : sp::ecs::Entity{};
+        if (target && (RadarBlockSystem::isRadarBlockedFrom(position, target, short_range) || Faction::getRelation(owner, target) != FactionRelation::Enemy))
+            target = {};
+
+        switch(ai->orders)
+        {
+        case AIOrder::Roaming:
+            planTargetSearch(position, target ? short_range + 2000.0f : long_range);
+            break;
+        case AIOrder::StandGround:
+        case AIOrder::FlyTowards:
+            planTargetSearch(position, short_range + 2000.0f);
+            break;
+        case AIOrder::DefendLocation:
+            planTargetSearch(ai->order_target_location, short_range + 2000.0f);
+            break;
+        case AIOrder::DefendTarget:
+            if (auto ott = ai->order_target.getComponent<sp::Transform>())
+                planTargetSearch(ott->getPosition(), short_range + 2000.0f);
+            break;
+        default:
+            break;
+        }
+    }
+
+    // And the search done by runOrders when roaming without a target.
+    if (ai->orders == AIOrder::Roaming && !target_component && (has_missiles || has_beams))
+        planTargetSearch(position, relay_range);
+}
+
+void ShipAI::think()
+{
+    for(size_t n=0; n<planned_target_search_count; n++)
+    {
+        auto& search = planned_target_searches[n];
+        search.result = searchBestThinkTarget(search.position, search.radius);
+    }
+}
+
+void ShipAI::clearThinkResults()
+{
+    planned_target_search_count = 0;
+}
+
+void ShipAI::planTargetSearch(glm::vec2 position, float radius)
+{
+    if (planned_target_search_count >= planned_target_searches.size())
+        return;
+    planned_target_searches[planned_target_search_count++] = {position, radius, {}};
+}
+
+void ShipAI::updateRanges()
+{
+    if (auto lrr = owner.getComponent<LongRangeRadar>()) {
+        long_range = lrr->long_range;
+        relay_range = long_range * 2.0f;
+        short_range = lrr->short_range;
+    }
+}
+
 static int getDirectionIndex(float direction, float arc)
 {
     if (fabs(angleDifference(direction, 0.0f)) < arc / 2.0f)
@@ -830,6 +951,18 @@ void ShipAI::flyFormation(sp::ecs::Entity target, glm::vec2 offset)
 }
 
 sp::ecs::Entity ShipAI::findBestTarget(glm::vec2 position, float radius)
+{
+    // Use the result of the think phase if it did this exact search.
+    for(size_t n=0; n<planned_target_search_count; n++)
+    {
+        auto& search = planned_target_searches[n];
+        if (search.position == position && search.radius == radius)
+            return search.result;
+    }
+    return searchBestTarget(position, radius);
+}
+
+sp::ecs::Entity ShipAI::searchBestTarget(glm::vec2 position, float radius)
 {
     float target_score = 0.0;
     sp::ecs::Entity target;
@@ -853,44 +986,68 @@ sp::ecs::Entity ShipAI::findBestTarget(glm::vec2 position, float radius)
     return target;
 }
 
+sp::ecs::Entity ShipAI::searchBestThinkTarget(glm::vec2 position, float radius) const
+{
+    // Same as searchBestTarget, on the copies made by prepareThinkTargets and prepareThink.
+    float target_score = 0.0;
+    sp::ecs::Entity target;
+    for(auto& candidate : think_targets)
+    {
+        if (std::abs(candidate.position.x - position.x) > radius || std::abs(candidate.position.y - position.y) > radius)
+            continue;
+        if (Faction::getRelationByMatrixIndex(think_faction_index, candidate.faction_index) != FactionRelation::Enemy)
+            continue;
+        if (!candidate.never_radar_blocked && RadarBlockSystem::isPositionBlockedFrom(think_owner.position, candidate.position, short_range))
+            continue;
+        float score = scoreTarget(think_owner, candidate.position, candidate.score_bonus, candidate.radar_link);
+        if (score == std::numeric_limits<float>::min())
+            continue;
+        if (!target || score > target_score)
+        {
+            target = candidate.entity;
+            target_score = score;
+        }
+    }
+    return target;
+}
+
 float ShipAI::targetScore(sp::ecs::Entity target)
 {
-    auto impulse = owner.getComponent<ImpulseEngine>();
     auto ot = owner.getComponent<sp::Transform>();
     if (!ot) return std::numeric_limits<float>::min();
     auto tt = target.getComponent<sp::Transform>();
     if (!tt) return std::numeric_limits<float>::min();
-    auto position_difference = tt->getPosition() - ot->getPosition();
+    auto thrusters = owner.getComponent<ManeuveringThrusters>();
+    auto impulse = owner.getComponent<ImpulseEngine>();
+    auto beamsystem = owner.getComponent<BeamWeaponSys>();
+    TargetScoreOwner<BeamWeaponSys::MountPoint> score_owner{ot->getPosition(), ot->getRotation(), thrusters ? thrusters->speed : 10.0f, impulse ? impulse->max_speed_forward : 0.0f, has_missiles, beam_weapon_range, beamsystem ? &beamsystem->mounts : nullptr};
+    return scoreTarget(score_owner, tt->getPosition(), targetScoreBonus(target), target.hasComponent<AllowRadarLink>());
+}
+
+template<typename MOUNT> float ShipAI::scoreTarget(const TargetScoreOwner<MOUNT>& from, glm::vec2 target_position, float bonus, bool radar_link)
+{
+    auto position_difference = target_position - from.position;
     float distance = glm::length(position_difference);
     //auto position_difference_normal = position_difference / distance;
     //float rel_velocity = dot(target->getVelocity(), position_difference_normal) - dot(getVelocity(), position_difference_normal);
-    float angle_difference = angleDifference(ot->getRotation(), vec2ToAngle(position_difference));
-    auto thrusters = owner.getComponent<ManeuveringThrusters>();
-    float score = -distance - std::abs(angle_difference / (thrusters ? thrusters->speed : 10.0f) * (impulse ? impulse->max_speed_forward : 0.0f)) * 1.5f;
-    if (target.hasComponent<BeamWeaponSys>())
-        score += 2500;
-    if (target.hasComponent<MissileTubes>())
-        score += 2500;
-    if (target.hasComponent<DockingBay>())
-        score -= 1500;
-    if (target.hasComponent<AllowRadarLink>())
+    float angle_difference = angleDifference(from.rotation, vec2ToAngle(position_difference));
+    float score = -distance - std::abs(angle_difference / from.turn_speed * from.max_speed) * 1.5f;
+    score += bonus;
+    if (radar_link)
     {
         score -= 10000;
         if (distance > 5000)
             return std::numeric_limits<float>::min();
     }
-    if (distance < 5000 && has_missiles)
+    if (distance < 5000 && from.has_missiles)
         score += 500;
 
-    if (distance < beam_weapon_range)
+    if (distance < from.beam_weapon_range && from.mounts)
     {
-        auto beamsystem = owner.getComponent<BeamWeaponSys>();
-        if (beamsystem) {
-            for(auto& mount : beamsystem->mounts) {
-                if (distance < mount.range) {
-                    if (fabs(angleDifference(angle_difference, mount.direction)) < mount.arc / 2.0f)
-                        score += 1000;
-                }
+        for(auto& mount : *from.mounts) {
+            if (distance < mount.range) {
+                if (fabs(angleDifference(angle_difference, mount.direction)) < mount.arc / 2.0f)
+                    score += 1000;
             }
         }
     }
@@ -5,6 +5,8 @@
 #include "graphics/renderTarget.h"
 #include "systems/pathfinding.h"
 #include "components/missiletubes.h"
+#include <array>
+#include <vector>
 
 ///Forward declaration
 class CpuShip;
@@ -52,6 +54,16 @@ public:
      */
     virtual void run(float delta);
 
+    /**!
+     * When the AI system runs in parallel, prepareThinkTargets is called once and prepareThink for every AI on the main thread.
+     * Think then runs possibly on a worker thread, and precomputes the target searches that run is expected to do.
+     * It only uses the copies made by the prepare calls, never the components or the physics world.
+     */
+    static void prepareThinkTargets();
+    void prepareThink();
+    void think();
+    void clearThinkResults();
+
     /**!
      * Are we allowed to switch to a different AI right now?
      * When true is returned, and the CpuShip wants to change their AI this AI object will be destroyed and a new one will be created.
@@ -68,6 +80,7 @@ protected:
     virtual void flyTowards(glm::vec2 target, float keep_distance = 0.0);
     virtual void flyFormation(sp::ecs::Entity target, glm::vec2 offset);
 
+    void updateRanges();
     sp::ecs::Entity findBestTarget(glm::vec2 position, float radius);
     float targetScore(sp::ecs::Entity target);
 
@@ -99,6 +112,41 @@ protected:
             return 35;
         }
     }
+private:
+    struct PlannedTargetSearch
+    {
+        glm::vec2 position;
+        float radius;
+        sp::ecs::Entity result;
+    };
+    std::array<PlannedTargetSearch, 2> planned_target_searches;
+    size_t planned_target_search_count = 0;
+
+    // What the target score needs from the owner, read from the components or from the copy for the think phase.
+    template<typename MOUNT> struct TargetScoreOwner
+    {
+        glm::vec2 position;
+        float rotation;
+        float turn_speed;
+        float max_speed;
+        bool has_missiles;
+        float beam_weapon_range;
+        const std::vector<MOUNT>* mounts;
+    };
+    struct ThinkBeam
+    {
+        float range;
+        float direction;
+        float arc;
+    };
+    TargetScoreOwner<ThinkBeam> think_owner{};
+    std::vector<ThinkBeam> think_beams;
+    uint8_t think_faction_index = 0;
+
+    void planTargetSearch(glm::vec2 position, float radius);
+    sp::ecs::Entity searchBestTarget(glm::vec2 position, float radius);
+    sp::ecs::Entity searchBestThinkTarget(glm::vec2 position, float radius) const;
+    template<typename MOUNT> static float scoreTarget(const TargetScoreOwner<MOUNT>& from, glm::vec2 target_position, float bonus, bool radar_link);
 };
 
 #endif//AI_H
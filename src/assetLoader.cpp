@@ -0,0 +1,289 @@
+#include "assetLoader.h"
+#include "mesh.h"
+#include "preferenceManager.h"
+#include "resources.h"
+#include "textureManager.h"
+#include "logging.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+
+static AssetLoader* asset_loader = nullptr;
+
+namespace
+{
+    // Resource stream over a copy of a file, so workers can decode without touching the resource providers.
+    class MemoryResourceStream : public ResourceStream
+    {
+        std::vector<uint8_t> buffer;
+        size_t read_position = 0;
+    public:
+        MemoryResourceStream(std::vector<uint8_t>&& buffer)
+        : buffer(std::move(buffer))
+        {
+        }
+
+        virtual size_t read(void* data, size_t size) override
+        {
+            size = std::min(size, buffer.size() - read_position);
+            memcpy(data, buffer.data() + read_position, size);
+            read_position += size;
+            return size;
+        }
+        virtual size_t seek(size_t position) override
+        {
+            read_position = std::min(position, buffer.size());
+            return read_position;
+        }
+        virtual size_t tell() override
+        {
+            return read_position;
+        }
+        virtual size_t getSize() override
+        {
+            return buffer.size();
+        }
+    };
+
+    P<ResourceStream> readToMemory(const string& name)
+    {
+        P<ResourceStream> stream = getResourceStream(name);
+        if (!stream)
+            return NULL;
+        std::vector<uint8_t> buffer(stream->getSize());
+        buffer.resize(stream->read(buffer.data(), buffer.size()));
+        return new MemoryResourceStream(std::move(buffer));
+    }
+}
+
+AssetLoader::AssetLoader()
+{
+    upload_budget = PreferencesManager::get("asset_upload_budget", "4").toFloat() / 1000.0f;
+    int thread_count = PreferencesManager::get("asset_loader_threads", "2").toInt();
+    for(int n=0; n<thread_count; n++)
+        workers.emplace_back(&AssetLoader::workerLoop, this);
+}
+
+AssetLoader::~AssetLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop_workers = true;
+    }
+    work_available.notify_all();
+    for(auto& worker : workers)
+        worker.join();
+    if (asset_loader == this)
+        asset_loader = nullptr;
+}
+
+AssetLoader& AssetLoader::get()
+{
+    // Created on first use, so headless servers never start the worker threads.
+    if (!asset_loader)
+        asset_loader = new AssetLoader();
+    return *asset_loader;
+}
+
+Mesh* AssetLoader::getMesh(const string& name)
+{
+    if (Mesh* mesh = Mesh::findMesh(name))
+        return mesh;
+    get().request(Type::Mesh, name);
+    return nullptr;
+}
+
+sp::Texture* AssetLoader::getTexture(const string& name)
+{
+    // Uploaded textures are registered with the textureManager, so they are shared with the GUI and radar.
+    if (get().request(Type::Texture, name))
+        return textureManager.getTexture(name);
+    return nullptr;
+}
+
+sp::Texture* AssetLoader::getPlaceholderTexture()
+{
+    auto& loader = get();
+    if (!loader.placeholder_texture)
+    {
+        auto texture = std::make_unique<sp::BasicTexture>();
+        texture->loadFromImage(sp::Image({1, 1}, {255, 255, 255, 255}));
+        loader.placeholder_texture = std::move(texture);
+    }
+    return loader.placeholder_texture.get();
+}
+
+gl::CubemapTexture* AssetLoader::getCubemap(const string& name)
+{
+    auto& loader = get();
+    auto it = loader.cubemaps.find(name);
+    if (it != loader.cubemaps.end())
+        return it->second.get();
+    loader.request(Type::Cubemap, name);
+    if (!loader.placeholder_cubemap)
+    {
+        gl::CubemapTexture::Faces faces;
+        for(auto& face : faces)
+            face = sp::Image({1, 1}, {0, 0, 0, 255});
+        loader.placeholder_cubemap = std::make_unique<gl::CubemapTexture>(std::move(faces));
+    }
+    return loader.placeholder_cubemap.get();
+}
+
+void AssetLoader::prefetch(const string& name)
+{
+    if (name.endswith(".obj") || name.endswith(".model"))
+        getMesh(name);
+    else if (name.startswith("skybox/"))
+        getCubemap(name);
+    else
+        getTexture(name);
+}
+
+void AssetLoader::prefetchModelData(const string& script_name)
+{
+    P<ResourceStream> stream = getResourceStream(script_name);
+    if (!stream)
+        return;
+
+    // Only string literal arguments are picked up, anything computed is loaded when it is first drawn.
+    static const char* setters[] = {"setMesh(\"", "setTexture(\"", "setSpecular(\"", "setIllumination(\"", "setNormalMap(\""};
+    while(stream->tell() < stream->getSize())
+    {
+        string line = stream->readLine();
+        for(auto setter : setters)
+        {
+            int start = line.find(setter);
+            if (start < 0)
+                continue;
+            start += strlen(setter);
+            int end = line.find("\"", start);
+            if (end > start)
+                prefetch(line.substr(start, end));
+        }
+    }
+}
+
+void AssetLoader::update(float delta)
+{
+    // Upload at least one finished asset per frame, so loading always makes progress.
+    auto start = std::chrono::steady_clock::now();
+    while(true)
+    {
+        Job job;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (finished.empty())
+                break;
+            job = std::move(finished.front());
+            finished.pop_front();
+        }
+        upload(job);
+        if (std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count() >= upload_budget)
+            break;
+    }
+}
+
+bool AssetLoader::request(Type type, const string& name)
+{
+    auto& state = states[static_cast<int>(type)];
+    auto it = state.find(name);
+    if (it != state.end())
+        return it->second == State::Ready;
+    state[name] = State::Loading;
+
+    Job job;
+    job.type = type;
+    job.name = name;
+    open(job);
+    if (workers.empty())
+    {
+        load(job);
+        upload(job);
+        return state[name] == State::Ready;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(std::move(job));
+    }
+    work_available.notify_one();
+    return false;
+}
+
+void AssetLoader::workerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while(true)
+    {
+        work_available.wait(lock, [this]() { return stop_workers || !pending.empty(); });
+        if (stop_workers)
+            return;
+        Job job = std::move(pending.front());
+        pending.pop_front();
+        lock.unlock();
+        load(job);
+        lock.lock();
+        finished.push_back(std::move(job));
+    }
+}
+
+void AssetLoader::open(Job& job)
+{
+    switch(job.type)
+    {
+    case Type::Mesh:
+        job.streams = {readToMemory(job.name), readToMemory(job.name + ".mesh")};
+        break;
+    case Type::Texture:
+        job.streams = {readToMemory(job.name)};
+        break;
+    case Type::Cubemap:
+        for(auto& filename : gl::CubemapTexture::faceFilenames(job.name))
+            job.streams.push_back(readToMemory(filename));
+        break;
+    }
+}
+
+void AssetLoader::load(Job& job)
+{
+    switch(job.type)
+    {
+    case Type::Mesh:
+        job.success = Mesh::loadData(job.name, job.streams[0], job.streams[1], job.mesh);
+        break;
+    case Type::Texture:
+        job.success = job.streams[0] && job.image.loadFromStream(job.streams[0]);
+        break;
+    case Type::Cubemap: {
+        gl::CubemapTexture::Streams streams;
+        std::copy(job.streams.begin(), job.streams.end(), streams.begin());
+        job.success = gl::CubemapTexture::loadFaces(streams, job.faces);
+        } break;
+    }
+}
+
+void AssetLoader::upload(Job& job)
+{
+    states[static_cast<int>(job.type)][job.name] = job.success ? State::Ready : State::Failed;
+    if (!job.success)
+    {
+        LOG(WARNING) << "Failed to load asset: " << job.name;
+        return;
+    }
+    switch(job.type)
+    {
+    case Type::Mesh:
+        Mesh::addMesh(job.name, std::move(job.mesh));
+        break;
+    case Type::Texture:
+        textureManager.setTexture(job.name, job.image);
+        // Textures upload on the first bind, so do that here where it counts towards the budget.
+        textureManager.getTexture(job.name)->bind();
+        break;
+    case Type::Cubemap:
+        cubemaps[job.name] = std::make_unique<gl::CubemapTexture>(std::move(job.faces));
+        break;
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef ASSET_LOADER_H
+#define ASSET_LOADER_H
+
+#include "Updatable.h"
+#include "stringImproved.h"
+#include "graphics/texture.h"
+#include "graphics/image.h"
+#include "glObjects.h"
+#include "meshData.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class Mesh;
+
+// Loads meshes, textures and skyboxes without stalling the render thread.
+// Files are read into memory on the main thread, as the resource providers are not thread safe, and decoded
+// on worker threads (preference "asset_loader_threads", 0 loads synchronously). The results are uploaded
+// from update() within a per frame budget (preference "asset_upload_budget", in milliseconds).
+class AssetLoader : public Updatable
+{
+public:
+    // Returns nullptr until the mesh is loaded.
+    static Mesh* getMesh(const string& name);
+    // Returns nullptr until the texture is loaded.
+    static sp::Texture* getTexture(const string& name);
+    // Plain white texture to draw with while a texture is loading.
+    static sp::Texture* getPlaceholderTexture();
+    // Returns a black cubemap until the skybox is loaded.
+    static gl::CubemapTexture* getCubemap(const string& name);
+
+    // Start loading an asset before it is needed. Names ending in .obj or .model are meshes,
+    // names in the skybox/ directory are cubemaps and anything else is a texture.
+    static void prefetch(const string& name);
+    // Prefetch every mesh and texture that a model data script (like model_data.lua) refers to.
+    static void prefetchModelData(const string& script_name);
+
+    virtual void update(float delta) override;
+
+private:
+    enum class Type { Mesh, Texture, Cubemap };
+    enum class State { Loading, Ready, Failed };
+
+    struct Job
+    {
+        Type type;
+        string name;
+        // Only the job owning them references these streams, and the job is created and destroyed on the main thread.
+        std::vector<P<ResourceStream>> streams;
+        bool success = false;
+        MeshData mesh;
+        sp::Image image;
+        gl::CubemapTexture::Faces faces;
+    };
+
+    AssetLoader();
+    virtual ~AssetLoader();
+
+    static AssetLoader& get();
+
+    // Returns true when the asset is ready, else makes sure it is being loaded.
+    bool request(Type type, const string& name);
+    void workerLoop();
+    static void open(Job& job);
+    static void load(Job& job);
+    void upload(Job& job);
+
+    std::unordered_map<string, State> states[3];
+    std::unordered_map<string, std::unique_ptr<gl::CubemapTexture>> cubemaps;
+    std::unique_ptr<sp::Texture> placeholder_texture;
+    std::unique_ptr<gl::CubemapTexture> placeholder_cubemap;
+    float upload_budget;
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::deque<Job> pending;
+    std::deque<Job> finished;
+    bool stop_workers = false;
+};
+
+#endif//ASSET_LOADER_H
@@ -15,7 +15,7 @@ public:
         BigEntity,
         SmallEntity,
     } state = InternalState::New;
-    uint32_t position_hash = 0;
+    uint64_t grid_key = 0;
 };
 
 class DelayedAvoidObject
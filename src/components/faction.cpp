@@ -4,6 +4,66 @@
 
 static FactionInfo default_faction_info;
 
+// Dense matrix of the relations between all factions, so getRelation is a single lookup.
+// Index 0 is used for "no faction", which is neutral towards everything.
+static struct {
+    bool dirty = true;
+    std::vector<sp::ecs::Entity> factions;
+    std::vector<uint8_t> relations; // factions.size() * factions.size() entries.
+    std::vector<FactionInfo::Relation> snapshot; // Relations of all factions at build time, to detect changes.
+    std::vector<uint32_t> snapshot_counts;
+} relation_matrix;
+
+static uint8_t findRelationIndex(sp::ecs::Entity faction_entity)
+{
+    for(size_t n=1; n<relation_matrix.factions.size(); n++)
+        if (relation_matrix.factions[n] == faction_entity)
+            return n;
+    return 0;
+}
+
+static uint8_t getRelationIndex(Faction& faction)
+{
+    if (faction.relation_index >= relation_matrix.factions.size() || relation_matrix.factions[faction.relation_index] != faction.entity) {
+        auto index = findRelationIndex(faction.entity);
+        // Factions that are not in the matrix keep failing the check above, only write when something changes.
+        if (index != faction.relation_index)
+            faction.relation_index = index;
+    }
+    return faction.relation_index;
+}
+
+static void rebuildRelationMatrix()
+{
+    relation_matrix.dirty = false;
+    relation_matrix.factions.clear();
+    relation_matrix.snapshot.clear();
+    relation_matrix.snapshot_counts.clear();
+    relation_matrix.factions.push_back({});
+    for(auto [entity, info] : sp::ecs::Query<FactionInfo>()) {
+        if (relation_matrix.factions.size() > 255) {
+            LOG(Warning, "More than 255 factions, relations of faction ", info.name, " are ignored.");
+            break;
+        }
+        relation_matrix.factions.push_back(entity);
+    }
+
+    auto size = relation_matrix.factions.size();
+    relation_matrix.relations.assign(size * size, uint8_t(FactionRelation::Neutral));
+    for(size_t n=1; n<size; n++) {
+        auto info = relation_matrix.factions[n].getComponent<FactionInfo>();
+        relation_matrix.snapshot_counts.push_back(info->relations.size());
+        relation_matrix.snapshot.insert(relation_matrix.snapshot.end(), info->relations.begin(), info->relations.end());
+        // Walk backwards, so the first entry for a faction wins, like the linear search in FactionInfo::getRelation.
+        for(auto it = info->relations.rbegin(); it != info->relations.rend(); ++it) {
+            auto other = it->other_faction ? findRelationIndex(it->other_faction) : 0;
+            if (other == 0 && it->other_faction)
+                continue;
+            relation_matrix.relations[n * size + other] = uint8_t(it->relation);
+        }
+    }
+}
+
 
 sp::ecs::Entity Faction::find(const string& name)
 {
@@ -27,11 +87,60 @@ FactionInfo& Faction::getInfo(sp::ecs::Entity entity)
 
 FactionRelation Faction::getRelation(sp::ecs::Entity a, sp::ecs::Entity b)
 {
-    auto fia = Faction::getInfo(a);
+    if (relation_matrix.dirty)
+        rebuildRelationMatrix();
+    auto fa = a.getComponent<Faction>();
     auto fb = b.getComponent<Faction>();
-    if (fb)
-        return fia.getRelation(fb->entity);
-    return fia.getRelation({});
+    uint8_t index_a = fa ? getRelationIndex(*fa) : 0;
+    uint8_t index_b = fb ? getRelationIndex(*fb) : 0;
+    return FactionRelation(relation_matrix.relations[index_a * relation_matrix.factions.size() + index_b]);
+}
+
+void Faction::updateRelationMatrix()
+{
+    if (relation_matrix.dirty) {
+        rebuildRelationMatrix();
+        return;
+    }
+    // The relations can be changed directly by scripts or by replication, so compare with what the matrix was build from.
+    size_t index = 1;
+    size_t offset = 0;
+    for(auto [entity, info] : sp::ecs::Query<FactionInfo>()) {
+        if (index > 255)
+            break;
+        if (index >= relation_matrix.factions.size() || relation_matrix.factions[index] != entity || relation_matrix.snapshot_counts[index - 1] != info.relations.size()) {
+            rebuildRelationMatrix();
+            return;
+        }
+        for(auto& relation : info.relations) {
+            auto& old = relation_matrix.snapshot[offset++];
+            if (old.other_faction != relation.other_faction || old.relation != relation.relation) {
+                rebuildRelationMatrix();
+                return;
+            }
+        }
+        index++;
+    }
+    if (index != relation_matrix.factions.size())
+        rebuildRelationMatrix();
+}
+
+void Faction::invalidateRelationMatrix()
+{
+    relation_matrix.dirty = true;
+}
+
+uint8_t Faction::getMatrixIndex(sp::ecs::Entity entity)
+{
+    if (relation_matrix.dirty)
+        rebuildRelationMatrix();
+    auto faction = entity.getComponent<Faction>();
+    return faction ? getRelationIndex(*faction) : 0;
+}
+
+FactionRelation Faction::getRelationByMatrixIndex(uint8_t a, uint8_t b)
+{
+    return FactionRelation(relation_matrix.relations[a * relation_matrix.factions.size() + b]);
 }
 
 // TODO: Info about multiple components belongs in systems, not in component code.
@@ -73,11 +182,13 @@ void FactionInfo::setRelation(sp::ecs::Entity faction_entity, FactionRelation re
         if (it.other_faction == faction_entity) {
             it.relation = relation;
             relations_dirty = true;
+            Faction::invalidateRelationMatrix();
             return;
         }
     }
     relations.push_back({faction_entity, relation});
     relations_dirty = true;
+    Faction::invalidateRelationMatrix();
 }
 
 FactionInfo* FactionInfo::find(const string& name)
@@ -20,11 +20,23 @@ class Faction
 public:
     sp::ecs::Entity entity;
 
+    // Internal state, index of our faction in the relation matrix, cached by getRelation.
+    uint8_t relation_index = 0;
+
     static sp::ecs::Entity find(const string& name);
     static FactionInfo& getInfo(sp::ecs::Entity entity);
     static FactionRelation getRelation(sp::ecs::Entity a, sp::ecs::Entity b);
 
     static void didAnOffensiveAction(sp::ecs::Entity entity);
+
+    // Rebuild the relation matrix if it no longer matches the relations of all FactionInfo components.
+    static void updateRelationMatrix();
+    // Force a rebuild of the relation matrix on the next getRelation call.
+    static void invalidateRelationMatrix();
+    // Index of the faction of an entity in the relation matrix, 0 without a faction. Together with getRelationByMatrixIndex,
+    // this lets a copy of the world answer getRelation without the components, like the parallel AI think phase does.
+    static uint8_t getMatrixIndex(sp::ecs::Entity entity);
+    static FactionRelation getRelationByMatrixIndex(uint8_t a, uint8_t b);
 };
 
 class FactionInfo
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "components/shipsystem.h"
+#include <unordered_map>
 #include <vector>
 
 // Internal composition of a ship.
@@ -27,6 +28,26 @@ public:
     ShipSystem::Type getSystemAtRoom(glm::ivec2 pos);
 
     bool auto_repair_enabled = false; // Repair crew with auto target damaged rooms
+
+    // Internal state of the InternalCrewSystem, not replicated. The walkable cells of the rooms and how they connect,
+    // rebuilt when the rooms or doors no longer match the ones it was built from. Each ship has its own, so crews
+    // of different ships can be pathed independently.
+    struct Navigation {
+        std::vector<Room> rooms;
+        std::vector<Door> doors;
+        glm::ivec2 origin{0, 0};
+        glm::ivec2 size{0, 0};
+        std::vector<uint8_t> links; // Per cell, a bit per direction that can be walked, and a bit per direction that goes through a door.
+        std::unordered_map<uint64_t, int> next_step; // From and to cell, to the next cell on the shortest path, or -1 if there is none.
+
+        // Search state, kept between searches so a search does not allocate.
+        std::vector<float> cost;
+        std::vector<int> came_from;
+        std::vector<uint32_t> visited; // Number of the search that last reached the cell.
+        uint32_t search = 0;
+        std::vector<std::pair<float, int>> open;
+    };
+    Navigation navigation;
 };
 
 class InternalCrew
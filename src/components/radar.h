@@ -20,6 +20,9 @@ public:
     glm::u8vec4 color{255,255,255,255};
 
     uint32_t flags = Rotate | LongRange;
+
+    // Not replicated, index of the icon in the icon table of the radar renderer. Checked against icon before use.
+    uint16_t icon_index = 0;
 };
 
 
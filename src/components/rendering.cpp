@@ -1,39 +1,41 @@
 #include "mesh.h"
-#include "textureManager.h"
+#include "assetLoader.h"
 #include "rendering.h"
 
 Mesh* MeshRenderComponent::getMesh()
 {
     if (!mesh.ptr && !mesh.name.empty())
-        mesh.ptr = Mesh::getMesh(mesh.name);
+        mesh.ptr = AssetLoader::getMesh(mesh.name);
     return mesh.ptr;
 }
 
 sp::Texture* MeshRenderComponent::getTexture()
 {
     if (!texture.ptr && !texture.name.empty())
-        texture.ptr = textureManager.getTexture(texture.name);
+        texture.ptr = AssetLoader::getTexture(texture.name);
+    if (!texture.ptr && !texture.name.empty())
+        return AssetLoader::getPlaceholderTexture();
     return texture.ptr;
 }
 
 sp::Texture* MeshRenderComponent::getSpecularTexture()
 {
     if (!specular_texture.ptr && !specular_texture.name.empty())
-        specular_texture.ptr = textureManager.getTexture(specular_texture.name);
+        specular_texture.ptr = AssetLoader::getTexture(specular_texture.name);
     return specular_texture.ptr;
 }
 
 sp::Texture* MeshRenderComponent::getIlluminationTexture()
 {
     if (!illumination_texture.ptr && !illumination_texture.name.empty())
-        illumination_texture.ptr = textureManager.getTexture(illumination_texture.name);
+        illumination_texture.ptr = AssetLoader::getTexture(illumination_texture.name);
     return illumination_texture.ptr;
 }
 
 sp::Texture* MeshRenderComponent::getNormalTexture()
 {
     if (!normal_texture.ptr && !normal_texture.name.empty())
-        normal_texture.ptr = textureManager.getTexture(normal_texture.name);
+        normal_texture.ptr = AssetLoader::getTexture(normal_texture.name);
     return normal_texture.ptr;
 }
 
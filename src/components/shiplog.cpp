@@ -1,5 +1,6 @@
 #include "components/shiplog.h"
 #include "gameGlobalInfo.h"
+#include <algorithm>
 
 
 void ShipLog::add(const string& message, glm::u8vec4 color)
@@ -9,19 +10,89 @@ void ShipLog::add(const string& message, glm::u8vec4 color)
 
 void ShipLog::add(const string& prefix, const string& message, glm::u8vec4 color)
 {
-    // Cap the ship's log size to 10,000 entries. If it exceeds that limit,
-    // start erasing entries from the beginning.
-    if (entries.size() > 10000)
-        entries.erase(entries.begin());
-
     // Timestamp a log entry, color it, and add it to the end of the log.
-    entries.push_back({prefix, message, color});
-    new_entry_count += 1;
+    auto& e = pushBack();
+    e.prefix = prefix;
+    e.text = message;
+    e.color = color;
+    e.seq = next_seq++;
 }
 
 void ShipLog::clear()
 {
     cleared = true;
-    new_entry_count = 0;
-    entries.clear();
-}
\ No newline at end of file
+    start = 0;
+    count = 0;
+}
+
+void ShipLog::clear(uint32_t seq)
+{
+    start = 0;
+    count = 0;
+    next_seq = seq;
+}
+
+void ShipLog::addReceived(uint32_t seq, const string& prefix, const string& message, glm::u8vec4 color)
+{
+    if (seq < next_seq)
+        return; // Already have this one.
+    if (seq > next_seq) {
+        // Missed entries, keep the log contiguous by dropping what we had.
+        start = 0;
+        count = 0;
+    }
+    auto& e = pushBack();
+    e.prefix = prefix;
+    e.text = message;
+    e.color = color;
+    e.seq = seq;
+    next_seq = seq + 1;
+}
+
+void ShipLog::addReceivedHistory(uint32_t seq, const string& prefix, const string& message, glm::u8vec4 color)
+{
+    // History is received newest first, and only fits in front of the entries we already have.
+    if (seq + 1 != getFirstSeq() || count >= max_entries)
+        return;
+    auto& e = pushFront();
+    e.prefix = prefix;
+    e.text = message;
+    e.color = color;
+    e.seq = seq;
+}
+
+ShipLog::Entry& ShipLog::pushBack()
+{
+    if (count == entries.size() && entries.size() < max_entries)
+        grow();
+    if (count == entries.size()) {
+        // Full, overwrite the oldest entry. Re-assigning the strings reuses their memory.
+        auto& e = entries[start];
+        start = (start + 1) % entries.size();
+        return e;
+    }
+    count++;
+    return entries[(start + count - 1) % entries.size()];
+}
+
+ShipLog::Entry& ShipLog::pushFront()
+{
+    if (count == entries.size())
+        grow();
+    start = (start + entries.size() - 1) % entries.size();
+    count++;
+    return entries[start];
+}
+
+void ShipLog::grow()
+{
+    // Grow the buffer, and put the entries back in order.
+    auto new_size = std::min(std::max(entries.size() * 2, size_t(64)), max_entries);
+    std::vector<Entry> grown;
+    grown.reserve(new_size);
+    for(size_t n=0; n<count; n++)
+        grown.push_back(std::move(entries[(start + n) % entries.size()]));
+    grown.resize(new_size);
+    entries = std::move(grown);
+    start = 0;
+}
@@ -8,12 +8,16 @@
 class ShipLog
 {
 public:
+    // Cap the ship's log size to 10,000 entries, the oldest entries are dropped after that.
+    static constexpr size_t max_entries = 10000;
+
     class Entry
     {
     public:
         string prefix;
         string text;
         glm::u8vec4 color;
+        uint32_t seq = 0; // Increases by one for every entry added to the log, never reused.
 
         bool operator!=(const Entry& e) const { return prefix != e.prefix || text != e.text || color != e.color; }
     };
@@ -22,12 +26,29 @@ public:
     void add(const string& prefix, const string& message, glm::u8vec4 color);
     void clear();
 
-    size_t size() const { return entries.size(); }
-    const Entry& get(size_t index) const { return entries[index]; }
+    size_t size() const { return count; }
+    const Entry& get(size_t index) const { return entries[(start + index) % entries.size()]; }
+    // Sequence number of the oldest entry in the log, equal to getNextSeq() when the log is empty.
+    uint32_t getFirstSeq() const { return count ? get(0).seq : next_seq; }
+    uint32_t getNextSeq() const { return next_seq; }
+
+    // Used by replication on the client, to store entries with the sequence numbers of the server.
+    void clear(uint32_t seq);
+    void addReceived(uint32_t seq, const string& prefix, const string& message, glm::u8vec4 color);
+    void addReceivedHistory(uint32_t seq, const string& prefix, const string& message, glm::u8vec4 color);
 
     // Info for replication
     bool cleared = false;
-    size_t new_entry_count = 0;
+    std::vector<uint32_t> history_requests; // On the server: clients want the entries before these sequence numbers, each client asks for its own.
+    uint32_t history_first_seq = 0; // On the client: oldest sequence number the server still has.
 private:
+    Entry& pushBack();
+    Entry& pushFront();
+    void grow();
+
+    // Ring buffer, grows up to max_entries, after that the oldest entry is overwritten.
     std::vector<Entry> entries;
+    size_t start = 0;
+    size_t count = 0;
+    uint32_t next_seq = 0;
 };
@@ -90,6 +90,22 @@ ShipSystem* ShipSystem::get(sp::ecs::Entity entity, Type type)
     return nullptr;
 }
 
+ShipSystem::Table ShipSystem::getAll(sp::ecs::Entity entity)
+{
+    Table table;
+    table[int(Type::Reactor)] = entity.getComponent<Reactor>();
+    table[int(Type::BeamWeapons)] = entity.getComponent<BeamWeaponSys>();
+    table[int(Type::MissileSystem)] = entity.getComponent<MissileTubes>();
+    table[int(Type::Maneuver)] = entity.getComponent<ManeuveringThrusters>();
+    table[int(Type::Impulse)] = entity.getComponent<ImpulseEngine>();
+    table[int(Type::Warp)] = entity.getComponent<WarpDrive>();
+    table[int(Type::JumpDrive)] = entity.getComponent<JumpDrive>();
+    auto shields = entity.getComponent<Shields>();
+    table[int(Type::FrontShield)] = shields ? &shields->front_system : nullptr;
+    table[int(Type::RearShield)] = (shields && shields->entries.size() > 1) ? &shields->rear_system : nullptr;
+    return table;
+}
+
 string getSystemName(ShipSystem::Type system)
 {
     switch(system)
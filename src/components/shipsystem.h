@@ -2,6 +2,7 @@
 
 #include "ecs/entity.h"
 #include <cmath>
+#include <array>
 
 //Base class for ship systems, ever created directly, use as base class for other components.
 class ShipSystem
@@ -53,6 +54,11 @@ public:
     }
 
     static ShipSystem* get(sp::ecs::Entity entity, Type type);
+
+    // All systems of an entity indexed by Type, nullptr for systems the entity does not have.
+    // Components move in memory when any entity gains or loses one, so build this per update, do not store it.
+    using Table = std::array<ShipSystem*, COUNT>;
+    static Table getAll(sp::ecs::Entity entity);
 };
 
 string getSystemName(ShipSystem::Type system);
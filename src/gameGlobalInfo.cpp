@@ -12,7 +12,11 @@
 #include "ecs/query.h"
 #include "menus/luaConsole.h"
 #include "playerInfo.h"
+#include "profiler.h"
+#include "simulationClock.h"
 #include <SDL_assert.h>
+#include <algorithm>
+#include <chrono>
 
 P<GameGlobalInfo> gameGlobalInfo;
 
@@ -101,6 +105,7 @@ void GameGlobalInfo::setVictory(string faction_name)
 
 void GameGlobalInfo::update(float delta)
 {
+    delta = SimulationClock::tickDelta(delta);
     if (global_message_timeout > 0.0f)
     {
         global_message_timeout -= delta;
@@ -113,7 +118,11 @@ void GameGlobalInfo::update(float delta)
     }
     elapsed_time += delta;
 
+    static auto profiler_update = Profiler::getSection("script", "update");
+    static auto profiler_resume = Profiler::getSection("script", "coroutine_resume");
+    static auto profiler_additional = Profiler::getSection("script", "additional_update");
     if (main_scenario_script && main_script_error_count < max_repeated_script_errors) {
+        Profiler::Scope scope(profiler_update);
         auto res = main_scenario_script->call<void>("update", delta);
         if (res.isErr() && res.error() != "Not a function") {
             LuaConsole::checkResult(res);
@@ -125,25 +134,87 @@ void GameGlobalInfo::update(float delta)
             main_script_error_count = 0;
         }
     }
-    script_threads.insert(script_threads.end(), new_script_threads.begin(), new_script_threads.end());
+    for(auto& coroutine : new_script_threads)
+    {
+        ScriptThread thread;
+        thread.coroutine = coroutine;
+        scheduleScriptThread(std::move(thread), elapsed_time);
+    }
     new_script_threads.clear();
-    for(auto it = script_threads.begin(); it != script_threads.end(); )
+
+    //Take out everything that is due first, threads that yield without a delay are due again on the next update, not this one.
+    due_script_threads.clear();
+    while(!script_threads.empty() && script_threads.front().wake_time <= elapsed_time)
     {
-        auto res = (*it)->resume(delta);
+        std::pop_heap(script_threads.begin(), script_threads.end());
+        due_script_threads.push_back(std::move(script_threads.back()));
+        script_threads.pop_back();
+    }
+    for(auto& thread : due_script_threads)
+    {
+        if (thread.condition && !thread.condition->check())
+        {
+            scheduleScriptThread(std::move(thread), elapsed_time + thread.condition_interval);
+            continue;
+        }
+
+        Profiler::Scope scope(profiler_resume);
+        script_yield_request = {};
+        auto start = std::chrono::steady_clock::now();
+        auto res = thread.coroutine->resume(delta);
+        double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
         LuaConsole::checkResult(res);
-        if (res.isErr() || !res.value()) {
-            it = script_threads.erase(it);
-        } else {
-            ++it;
+        bool running = !res.isErr() && res.value();
+
+        if (thread.location.empty() && !script_yield_request.location.empty())
+        {
+            thread.location = script_yield_request.location;
+            script_thread_stats[thread.location].threads++;
         }
+        auto& stats = script_thread_stats[thread.location.empty() ? string("(finished without yielding)") : thread.location];
+        stats.resumes++;
+        stats.time += time;
+        if (!running)
+        {
+            if (!thread.location.empty())
+                stats.threads--;
+            continue;
+        }
+
+        thread.condition = std::move(script_yield_request.condition);
+        thread.condition_interval = thread.condition ? script_yield_request.delay : 0.0f;
+        scheduleScriptThread(std::move(thread), elapsed_time + (thread.condition ? 0.0f : script_yield_request.delay));
     }
+    due_script_threads.clear();
     for(auto& as : additional_scripts) {
+        Profiler::Scope scope(profiler_additional);
         auto res = as->call<void>("update", delta);
         if (res.isErr() && res.error() != "Not a function")
             LuaConsole::checkResult(res);
     }
 }
 
+void GameGlobalInfo::scheduleScriptThread(ScriptThread&& thread, float wake_time)
+{
+    thread.wake_time = wake_time;
+    thread.order = script_thread_order++;
+    script_threads.push_back(std::move(thread));
+    std::push_heap(script_threads.begin(), script_threads.end());
+}
+
+string GameGlobalInfo::getScriptThreadStats()
+{
+    std::vector<std::pair<string, ScriptThreadStats>> sorted(script_thread_stats.begin(), script_thread_stats.end());
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.second.time > b.second.time; });
+    string result = string(int(script_threads.size())) + " threads, ms total, resumes, ms per resume, running threads:";
+    for(auto& [location, stats] : sorted)
+    {
+        result += "\n" + location + ": " + string(float(stats.time * 1000.0), 2) + ", " + string(std::to_string(stats.resumes)) + ", "
+            + string(float(stats.time * 1000.0 / std::max<uint64_t>(stats.resumes, 1)), 3) + ", " + string(stats.threads);
+    }
+    return result;
+}
+
 string GameGlobalInfo::getNextShipCallsign()
 {
     callsign_counter += 1;
@@ -342,6 +413,8 @@ void GameGlobalInfo::startScenario(string filename, std::unordered_map<string, s
     i18n::load("locale/" + filename.replace(".lua", "." + PreferencesManager::get("language", "en") + ".po"));
 
     script_environment_base = std::make_unique<sp::script::Environment>();
+    static int script_environment_counter = 0;
+    script_environment_generation = ++script_environment_counter;
     main_script_error_count = 0;
     if (setupScriptEnvironment(*script_environment_base.get())) {
         auto res = script_environment_base->runFile<void>("model_data.lua");
@@ -118,13 +118,41 @@ public:
     std::vector<std::unique_ptr<sp::script::Environment>> additional_scripts;
     std::unique_ptr<sp::script::Environment> script_environment_base;
     std::unique_ptr<sp::script::Environment> main_scenario_script;
-    std::vector<sp::script::CoroutinePtr> script_threads;
+    //Unique for every script_environment_base created, environments derived from it elsewhere rebuild when it changes.
+    int script_environment_generation = 0;
     std::vector<sp::script::CoroutinePtr> new_script_threads;
+    //Time spent in script threads, per function they were started with.
+    string getScriptThreadStats();
 private:
     sp::ecs::Entity victory_faction;
     int callsign_counter;
 
     int main_script_error_count = 0;
+
+    //Threads started with startThread, in a min heap on the time they wake up. Waiting threads are not resumed,
+    //a thread waiting for a condition only has its condition function called.
+    struct ScriptThread
+    {
+        sp::script::CoroutinePtr coroutine;
+        float wake_time = 0.0f;
+        uint64_t order = 0; //Threads due at the same time run in the order they started waiting.
+        std::shared_ptr<ScriptThreadCondition> condition;
+        float condition_interval = 0.0f;
+        string location;
+
+        bool operator<(const ScriptThread& other) const { return wake_time > other.wake_time || (wake_time == other.wake_time && order > other.order); }
+    };
+    std::vector<ScriptThread> script_threads;
+    std::vector<ScriptThread> due_script_threads;
+    uint64_t script_thread_order = 0;
+    struct ScriptThreadStats
+    {
+        int threads = 0;
+        uint64_t resumes = 0;
+        double time = 0.0;
+    };
+    std::unordered_map<string, ScriptThreadStats> script_thread_stats;
+    void scheduleScriptThread(ScriptThread&& thread, float wake_time);
     static constexpr int max_repeated_script_errors = 5;
 
     constexpr static int16_t CMD_PLAY_CLIENT_SOUND = 0x0001;
@@ -92,31 +92,29 @@ namespace gl
     }
 
     CubemapTexture::CubemapTexture(const string& file_path)
+        : CubemapTexture(loadFaces(file_path))
     {
-        // Load up the cube texture.
-        // Face setup
-        std::array<std::tuple<string, uint32_t>, 6> faces{
-            std::make_tuple(file_path + "/right.png", GL_TEXTURE_CUBE_MAP_POSITIVE_X),
-            std::make_tuple(file_path + "/left.png", GL_TEXTURE_CUBE_MAP_NEGATIVE_X),
-            std::make_tuple(file_path + "/top.png", GL_TEXTURE_CUBE_MAP_POSITIVE_Y),
-            std::make_tuple(file_path + "/bottom.png", GL_TEXTURE_CUBE_MAP_NEGATIVE_Y),
-            std::make_tuple(file_path + "/front.png", GL_TEXTURE_CUBE_MAP_POSITIVE_Z),
-            std::make_tuple(file_path + "/back.png", GL_TEXTURE_CUBE_MAP_NEGATIVE_Z),
+        LOG(Info, "Loaded cubemap: ", file_path);
+    }
+
+    CubemapTexture::CubemapTexture(Faces&& faces)
+    {
+        // Face setup, in the same order as loadFaces.
+        static constexpr std::array<uint32_t, 6> targets{
+            GL_TEXTURE_CUBE_MAP_POSITIVE_X,
+            GL_TEXTURE_CUBE_MAP_NEGATIVE_X,
+            GL_TEXTURE_CUBE_MAP_POSITIVE_Y,
+            GL_TEXTURE_CUBE_MAP_NEGATIVE_Y,
+            GL_TEXTURE_CUBE_MAP_POSITIVE_Z,
+            GL_TEXTURE_CUBE_MAP_NEGATIVE_Z,
         };
 
         // Upload
         glBindTexture(GL_TEXTURE_CUBE_MAP, texture[0]);
-        sp::Image image;
-        for (const auto& face : faces)
+        for (size_t n = 0; n < faces.size(); n++)
         {
-            auto stream = getResourceStream(std::get<0>(face));
-            if (!stream || !image.loadFromStream(stream))
-            {
-                LOG(Warning, "Failed to load texture: ", std::get<0>(face));
-                image = sp::Image({8, 8}, {255, 0, 255, 128});
-            }
-
-            glTexImage2D(std::get<1>(face), 0, GL_RGBA, image.getSize().x, image.getSize().y, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.getPtr());
+            auto& image = faces[n];
+            glTexImage2D(targets[n], 0, GL_RGBA, image.getSize().x, image.getSize().y, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.getPtr());
         }
 
         // Make it pretty.
@@ -130,8 +128,48 @@ namespace gl
         if (GLAD_GL_ES_VERSION_2_0)
             glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
         glBindTexture(GL_TEXTURE_CUBE_MAP, GL_NONE);
+    }
 
-        LOG(Info, "Loaded cubemap: ", file_path);
+    CubemapTexture::Faces CubemapTexture::loadFaces(const string& file_path)
+    {
+        // Load up the cube texture.
+        Streams streams;
+        auto filenames = faceFilenames(file_path);
+        for (size_t n = 0; n < streams.size(); n++)
+            streams[n] = getResourceStream(filenames[n]);
+
+        Faces faces;
+        for (size_t n = 0; n < faces.size(); n++)
+        {
+            if (!streams[n] || !faces[n].loadFromStream(streams[n]))
+            {
+                LOG(Warning, "Failed to load texture: ", filenames[n]);
+                faces[n] = sp::Image({8, 8}, {255, 0, 255, 128});
+            }
+        }
+        return faces;
+    }
+
+    std::array<string, 6> CubemapTexture::faceFilenames(const string& file_path)
+    {
+        return {
+            file_path + "/right.png",
+            file_path + "/left.png",
+            file_path + "/top.png",
+            file_path + "/bottom.png",
+            file_path + "/front.png",
+            file_path + "/back.png",
+        };
+    }
+
+    bool CubemapTexture::loadFaces(const Streams& streams, Faces& faces)
+    {
+        for (size_t n = 0; n < faces.size(); n++)
+        {
+            if (!streams[n] || !faces[n].loadFromStream(streams[n]))
+                return false;
+        }
+        return true;
     }
 
     void CubemapTexture::bind()
@@ -6,6 +6,8 @@
 #include <cstdint>
 #include <limits>
 #include <stringImproved.h>
+#include <graphics/image.h>
+#include <resources.h>
 
 
 namespace gl
@@ -191,7 +193,19 @@ namespace gl
     class CubemapTexture
     {
     public:
+        using Faces = std::array<sp::Image, 6>;
+        using Streams = std::array<P<ResourceStream>, 6>;
+
         CubemapTexture(const string& file_path);
+        explicit CubemapTexture(Faces&& faces);
+
+        // Decode the six faces of a cubemap, missing faces are replaced by a placeholder.
+        static Faces loadFaces(const string& file_path);
+        // Resource names of the six faces, in the order loadFaces and the constructor use.
+        static std::array<string, 6> faceFilenames(const string& file_path);
+        // Decode faces from already opened streams. Does not touch OpenGL or the resource providers,
+        // so it can run on a worker thread. Returns false if any face is missing or fails to decode.
+        static bool loadFaces(const Streams& streams, Faces& faces);
 
         void bind();
     private:
@@ -1,6 +1,8 @@
 #include "debugRenderer.h"
 #include "multiplayer_server.h"
 #include "hotkeyConfig.h"
+#include "multiplayer/interest.h"
+#include "profiler.h"
 
 static glm::u8vec4 line_colors[] = {
     {255, 0, 0, 255},
@@ -54,6 +56,11 @@ void DebugRenderer::render(sp::RenderTarget& renderer)
     {
         text = text + string(game_server->getSendDataRate() / 1000, 1) + " kb per second\n";
         text = text + string(game_server->getSendDataRatePerClient() / 1000, 1) + " kb per client\n";
+        // Component replication is one stream that every client receives in full, so this is not divided by the client count.
+        // The interest levels are likewise shared: the most interested client decides the level of an entity for everyone.
+        auto& interest = ReplicationInterest::getStats();
+        text = text + string(interest.bytes_per_second / 1000, 1) + " kb per second component stream (each client)\n";
+        text = text + "Replicating for all clients: " + string(interest.full) + " full, " + string(interest.reduced) + " reduced, " + string(interest.none) + " hidden\n";
     }
 
     if (show_timing_graph)
@@ -108,6 +115,18 @@ void DebugRenderer::render(sp::RenderTarget& renderer)
             index += 1;
         }
 
+        // Slowest profiled sections, so it is clear which system, script or replication class the time goes to.
+        std::vector<std::pair<const Profiler::Section*, Profiler::Percentiles>> sections;
+        for(auto& section : Profiler::getSections())
+            sections.emplace_back(section.get(), Profiler::getPercentiles(*section));
+        std::sort(sections.begin(), sections.end(), [](const auto& a, const auto& b) { return a.second.p90 > b.second.p90; });
+        if (sections.size() > 20)
+            sections.resize(20);
+        string profile_text = "p50 / p90 / p99 / max (ms)\n";
+        for(auto& [section, p] : sections)
+            profile_text += section->group + " " + section->name + ": " + string(p.p50 * 1000, 3) + " / " + string(p.p90 * 1000, 3) + " / " + string(p.p99 * 1000, 3) + " / " + string(p.max * 1000, 3) + "\n";
+        renderer.drawText(sp::Rect(window_size.x, 0, 0, 0), profile_text, sp::Alignment::TopRight, 16);
+
         //60FPS line
         renderer.drawLine({0, window_size.y - 166}, {window_size.x, window_size.y - 166}, glm::u8vec4{255,255,255,128});
 
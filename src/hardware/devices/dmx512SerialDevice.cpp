@@ -1,7 +1,10 @@
 #include "dmx512SerialDevice.h"
 #include "hardware/serialDriver.h"
+#include "hardware/serialFrameScheduler.h"
 #include "logging.h"
 
+#include <algorithm>
+
 DMX512SerialDevice::DMX512SerialDevice()
 {
     port = nullptr;
@@ -9,18 +12,16 @@ DMX512SerialDevice::DMX512SerialDevice()
         data_stream[n] = 0;
     channel_count = 512;
     resend_delay = 25;
-    run_thread = false;
+    keep_alive_delay = 800;
 }
 
 DMX512SerialDevice::~DMX512SerialDevice()
 {
-    if (run_thread)
-    {
-        run_thread = false;
-        update_thread.join();
-    }
     if (port)
+    {
+        SerialFrameScheduler::remove(port);
         delete port;
+    }
 }
 
 bool DMX512SerialDevice::configure(std::unordered_map<string, string> settings)
@@ -31,8 +32,8 @@ bool DMX512SerialDevice::configure(std::unordered_map<string, string> settings)
         if (!port->isOpen())
         {
             LOG(ERROR) << "Failed to open port: " << settings["port"] << " for DMX512SerialDevice";
-            port = nullptr;
             delete port;
+            port = nullptr;
         }
     }
     if (settings.find("channels") != settings.end())
@@ -43,10 +44,25 @@ bool DMX512SerialDevice::configure(std::unordered_map<string, string> settings)
     {
         resend_delay = settings["resend_delay"].toInt();
     }
+    if (settings.find("keep_alive") != settings.end())
+    {
+        keep_alive_delay = settings["keep_alive"].toInt();
+    }
     if (port)
     {
-        run_thread = true;
-        update_thread = std::move(std::thread(&DMX512SerialDevice::updateLoop, this));
+        //On the Open DMX USB controller, the RTS line is used to enable the RS485 transmitter.
+        port->clearRTS();
+
+        //Configure the port for straight DMX-512 protocol.
+        port->configure(250000, 8, SerialPort::NoParity, SerialPort::TwoStopbits);
+
+        //Every frame starts with a break, at least 88uSec (note, not all USB serial convertors implement BREAK sending)
+        SerialFrameScheduler::add(port, [this](std::vector<uint8_t>& frame)
+        {
+            bool changed = frame.size() != size_t(1 + channel_count) || !std::equal(frame.begin(), frame.end(), data_stream);
+            frame.assign(data_stream, data_stream + 1 + channel_count);
+            return changed;
+        }, std::chrono::milliseconds(resend_delay), std::chrono::milliseconds(keep_alive_delay), true);
         return true;
     }
     return false;
@@ -64,24 +80,3 @@ int DMX512SerialDevice::getChannelCount()
 {
     return channel_count;
 }
-
-void DMX512SerialDevice::updateLoop()
-{
-    //On the Open DMX USB controller, the RTS line is used to enable the RS485 transmitter.
-    port->clearRTS();
-
-    //Configure the port for straight DMX-512 protocol.
-    port->configure(250000, 8, SerialPort::NoParity, SerialPort::TwoStopbits);
-
-    while(run_thread)
-    {
-        //Send a break to initiate transfer, break needs to be at least 88uSec (note, not all USB serial convertors implement BREAK sending)
-        port->sendBreak();
-
-        //Send the channel data.
-        port->send(data_stream, 1 + channel_count);
-
-        //Delay a bit before sending again.
-        std::this_thread::sleep_for(std::chrono::milliseconds(resend_delay));
-    }
-}
@@ -1,24 +1,26 @@
 #include "enttecDMXProDevice.h"
 #include "hardware/serialDriver.h"
+#include "hardware/serialFrameScheduler.h"
 #include "logging.h"
 
+#include <algorithm>
+
 EnttecDMXProDevice::EnttecDMXProDevice()
 {
     port = nullptr;
     for(int n=0; n<512; n++)
         channel_data[n] = 0;
     channel_count = 512;
+    resend_delay = 25;
 }
 
 EnttecDMXProDevice::~EnttecDMXProDevice()
 {
-    if (run_thread)
-    {
-        run_thread = false;
-        update_thread.join();
-    }
     if (port)
+    {
+        SerialFrameScheduler::remove(port);
         delete port;
+    }
 }
 
 bool EnttecDMXProDevice::configure(std::unordered_map<string, string> settings)
@@ -29,18 +31,34 @@ bool EnttecDMXProDevice::configure(std::unordered_map<string, string> settings)
         if (!port->isOpen())
         {
             LOG(ERROR) << "Failed to open port: " << settings["port"] << " for EnttecDMXProDevice";
-            port = nullptr;
             delete port;
+            port = nullptr;
         }
     }
     if (settings.find("channels") != settings.end())
     {
         channel_count = std::max(1, std::min(512, settings["channels"].toInt()));
     }
+    if (settings.find("resend_delay") != settings.end())
+    {
+        resend_delay = settings["resend_delay"].toInt();
+    }
     if (port)
     {
-        run_thread = true;
-        update_thread = std::thread(&EnttecDMXProDevice::updateLoop, this);
+        //Configuration does not real matter as it's just a virtual device.
+        port->configure(115200, 8, SerialPort::NoParity, SerialPort::OneStopBit);
+
+        //Output Only Send DMX Packet Request: start code, label, data length, DMX start byte, channel data and end code.
+        SerialFrameScheduler::add(port, [this](std::vector<uint8_t>& frame)
+        {
+            int size = channel_count + 1;
+            bool changed = frame.size() != size_t(5 + channel_count + 1) || !std::equal(channel_data, channel_data + channel_count, frame.begin() + 5);
+            frame.resize(5 + channel_count + 1);
+            frame[0] = 0x7E; frame[1] = 0x06; frame[2] = uint8_t(size & 0xFF); frame[3] = uint8_t(size >> 8); frame[4] = 0x00;
+            std::copy(channel_data, channel_data + channel_count, frame.begin() + 5);
+            frame[5 + channel_count] = 0xE7;
+            return changed;
+        }, std::chrono::milliseconds(resend_delay), std::chrono::milliseconds(1000), false);
         return true;
     }
     return false;
@@ -58,22 +76,3 @@ int EnttecDMXProDevice::getChannelCount()
 {
     return channel_count;
 }
-
-void EnttecDMXProDevice::updateLoop()
-{
-    //Configuration does not real matter as it's just a virtual device.
-    port->configure(115200, 8, SerialPort::NoParity, SerialPort::OneStopBit);
-
-    int size = channel_count + 1;
-    uint8_t start_code[5] = {0x7E, 0x06, uint8_t(size & 0xFF), uint8_t(size >> 8), 0x00};
-    uint8_t end_code[1] = {0xE7};
-    while(run_thread)
-    {
-        port->send(start_code, sizeof(start_code));
-        port->send(channel_data, channel_count);
-        port->send(end_code, sizeof(end_code));
-
-        //Delay a bit before sending again.
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    }
-}
@@ -3,7 +3,6 @@
 
 #include "hardware/hardwareOutputDevice.h"
 #include <stdint.h>
-#include <thread>
 
 //The DMX512SerialDevice can talk to Enttec DMX Pro hardware:
 // http://www.enttec.com/?main_menu=Products&pn=70304
@@ -12,10 +11,9 @@ class EnttecDMXProDevice : public HardwareOutputDevice
 {
 private:
     SerialPort* port;
-    std::thread update_thread;
 
-    bool run_thread;
     int channel_count;
+    int resend_delay;
     uint8_t channel_data[512];
 public:
     EnttecDMXProDevice();
@@ -23,6 +21,7 @@ public:
 
     //Configure the device.
     // Parameter: port: name of the serial port to connect to.
+    // Parameter: resend_delay: minimal time between frames in ms, default 25. The device keeps refreshing the DMX line by itself, so frames are only sent on changes.
     virtual bool configure(std::unordered_map<string, string> settings) override;
 
     //Set a hardware channel output. Value is 0.0 to 1.0 for no to max output.
@@ -30,9 +29,6 @@ public:
 
     //Return the number of output channels supported by this device.
     virtual int getChannelCount() override;
-
-private:
-    void updateLoop();
 };
 
 #endif//ENTTEC_DMX_PRO_DEVICE_H
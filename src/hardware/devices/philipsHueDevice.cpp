@@ -10,6 +10,10 @@
 
 #include "io/http/request.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
 PhilipsHueDevice::PhilipsHueDevice()
 {
     userfile = "philips_hue.name";
@@ -45,6 +49,10 @@ bool PhilipsHueDevice::configure(std::unordered_map<string, string> settings)
     {
         port = settings["port"].toInt();
     }
+    if (settings.find("requests_per_second") != settings.end())
+    {
+        requests_per_second = std::max(1, settings["requests_per_second"].toInt());
+    }
 
     //If no user name set, try to read it from the userfile.
     if (username == "")
@@ -143,14 +151,17 @@ bool PhilipsHueDevice::configure(std::unordered_map<string, string> settings)
             {
                 auto hue_json = json.value();
                 light_count = 0;
+                std::vector<string> light_ids;
                 for (const auto& entry : hue_json.items())
                 {
                     auto currentInt = string(entry.key()).toInt();
                     LOG(DEBUG) << "Got key from Hue API " << currentInt;
                     if (currentInt >= light_count) light_count = currentInt;
+                    light_ids.push_back(entry.key());
                 }
 
                 lights.resize(light_count);
+                setupGroup(light_ids);
 
                 FILE* f = fopen(userfile.c_str(), "wt");
                 if (f)
@@ -178,6 +189,57 @@ bool PhilipsHueDevice::configure(std::unordered_map<string, string> settings)
     return false;
 }
 
+void PhilipsHueDevice::setupGroup(const std::vector<string>& light_ids)
+{
+    //Group 0 is every light the bridge knows about, also the ones that are not part of the ship.
+    //So use a group of our own, found by name to not create a new one on every start.
+    static const std::string group_name = "EmptyEpsilon";
+    std::vector<std::string> ids(light_ids.begin(), light_ids.end());
+    group_id = "";
+    group_lights.clear();
+
+    sp::io::http::Request http(ip_address,port);
+    std::string err;
+    auto response = http.get(string{ "/api/" } + username + "/groups");
+    if (response.status == 200) // OK
+    {
+        if (auto json = sp::json::parse(response.body, err); json && json.value().is_object())
+        {
+            for (const auto& entry : json.value().items())
+            {
+                if (entry.value().is_object() && entry.value().value("name", std::string()) == group_name)
+                    group_id = entry.key();
+            }
+        }
+    }
+    if (group_id != "")
+    {
+        //Update the lights of the group, the configuration of the bridge could have changed since it was created.
+        response = http.request("put", string{ "/api/" } + username + "/groups/" + group_id, nlohmann::json{{"lights", ids}}.dump());
+        if (response.status != 200) // !OK
+            group_id = "";
+    }
+    else
+    {
+        //Responds with: [{"success":{"id":"1"}}]
+        response = http.post(string{ "/api/" } + username + "/groups", nlohmann::json{{"name", group_name}, {"lights", ids}, {"type", "LightGroup"}}.dump());
+        if (response.status == 200) // OK
+        {
+            if (auto json = sp::json::parse(response.body, err); json && json.value().is_array() && !json.value().empty() && json.value()[0].contains("success"))
+                group_id = json.value()[0]["success"].value("id", std::string());
+        }
+    }
+    if (group_id == "")
+    {
+        LOG(WARNING) << "Failed to set up a philips hue group, lights are set one by one: " << response.status;
+        LOG(WARNING) << response.body;
+        return;
+    }
+    for(auto& id : light_ids)
+        if (id.toInt() > 0)
+            group_lights.push_back(id.toInt() - 1);
+}
+
 void PhilipsHueDevice::setChannelData(int channel, float value)
 {
     int light_idx = channel / 4;
@@ -187,10 +249,10 @@ void PhilipsHueDevice::setChannelData(int channel, float value)
     std::lock_guard<std::mutex> lock(mutex);
     switch(channel % 4)
     {
-    case 0: if (lights[light_idx].brightness != value * 254) lights[light_idx].dirty = true; lights[light_idx].brightness = value * 254; break;
-    case 1: if (lights[light_idx].saturation != value * 254) lights[light_idx].dirty = true; lights[light_idx].saturation = value * 254; break;
-    case 2: if (lights[light_idx].hue != value * 65535) lights[light_idx].dirty = true; lights[light_idx].hue = value * 65535; break;
-    case 3: if (lights[light_idx].transitiontime != value) lights[light_idx].dirty = true; lights[light_idx].transitiontime = value; break;
+    case 0: lights[light_idx].brightness = value * 254; break;
+    case 1: lights[light_idx].saturation = value * 254; break;
+    case 2: lights[light_idx].hue = value * 65535; break;
+    case 3: lights[light_idx].transitiontime = value; break;
     }
 }
 
@@ -199,39 +261,107 @@ int PhilipsHueDevice::getChannelCount()
     return light_count * 4;
 }
 
+float PhilipsHueDevice::LightInfo::difference(const LightInfo& other) const
+{
+    //Switching on or off is the most visible change there is.
+    if ((brightness > 0) != (other.brightness > 0))
+        return 3.0f;
+    if (brightness == 0)
+        return transitiontime != other.transitiontime ? 0.01f : 0.0f;
+    int hue_difference = std::abs(hue - other.hue);
+    hue_difference = std::min(hue_difference, 65536 - hue_difference);
+    return std::abs(brightness - other.brightness) / 254.0f + std::abs(saturation - other.saturation) / 254.0f + hue_difference / 32768.0f + (transitiontime != other.transitiontime ? 0.01f : 0.0f);
+}
+
+string PhilipsHueDevice::LightInfo::toJson() const
+{
+    if (brightness > 0)
+        return "{\"on\":true, \"sat\":"+string(saturation)+", \"bri\":"+string(brightness)+",\"hue\":"+string(hue)+", \"transitiontime\": "+string(transitiontime)+"}";
+    return "{\"on\":false, \"transitiontime\": "+string(transitiontime)+"}";
+}
+
 void PhilipsHueDevice::updateLoop()
 {
     sp::io::http::Request http(ip_address,port);
+    auto request_delay = std::chrono::microseconds(1000000 / requests_per_second);
+    auto group_delay = std::chrono::seconds(1);
+    std::chrono::steady_clock::time_point last_group_request;
 
+    std::vector<LightInfo> targets;
+    //What the bridge was last told, the initial state is unknown so everything is sent once.
+    std::vector<LightInfo> sent(light_count);
+    std::vector<bool> sent_valid(light_count, false);
+    std::vector<std::chrono::steady_clock::time_point> changed_since(light_count);
+    std::vector<int> changed;
     while(run_thread)
     {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            targets = lights;
+        }
+        auto now = std::chrono::steady_clock::now();
+        changed.clear();
         for(int n=0; n<light_count; n++)
         {
-            if (lights[n].dirty)
+            if (sent_valid[n] && targets[n] == sent[n])
+                continue;
+            if (changed_since[n] == std::chrono::steady_clock::time_point{})
+                changed_since[n] = now;
+            changed.push_back(n);
+        }
+        if (changed.empty())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+
+        //All lights going to the same state, like an alert flashing, is a single request to our group of lights.
+        bool all_same = !group_lights.empty() && changed.size() > 1 && now - last_group_request >= group_delay;
+        for(size_t n=1; all_same && n<group_lights.size(); n++)
+            all_same = targets[group_lights[n]] == targets[group_lights[0]];
+        if (all_same)
+        {
+            auto& target = targets[group_lights[0]];
+            auto response = http.request("put", string{ "/api/" } + username + "/groups/" + group_id + "/action", target.toJson());
+            if (response.status != 200) // !OK
             {
-                LightInfo info;
-                {
-                    std::lock_guard<std::mutex> lock(mutex);
-                    lights[n].dirty = false;
-                    info = lights[n];
-                }
-                string post_data;
-                if (info.laststate != "sat-" + string(info.saturation) + "-bri-" + string(info.brightness) + "-hue-" + string(info.hue) + "-transition-" + string(info.transitiontime))
+                LOG(WARNING) << "Failed to set all lights philips hue bridge: " << response.status;
+                LOG(WARNING) << response.body;
+            }
+            last_group_request = now;
+            for(int n : group_lights)
+            {
+                sent[n] = target;
+                sent_valid[n] = true;
+                changed_since[n] = {};
+            }
+        }
+        else
+        {
+            //Send the light that changed the most, lights that have been waiting for a while go first eventually.
+            int best = -1;
+            float best_score = -1.0f;
+            for(int n : changed)
+            {
+                float score = (sent_valid[n] ? targets[n].difference(sent[n]) : 3.0f) + std::chrono::duration<float>(now - changed_since[n]).count();
+                if (score > best_score)
                 {
-                    lights[n].laststate = "sat-" + string(info.saturation) + "-bri-" + string(info.brightness) + "-hue-" + string(info.hue) + "-transition-" + string(info.transitiontime);
-                    if (info.brightness > 0)
-                        post_data = "{\"on\":true, \"sat\":"+string(info.saturation)+", \"bri\":"+string(info.brightness)+",\"hue\":"+string(info.hue)+", \"transitiontime\": "+string(info.transitiontime)+"}";
-                    else
-                        post_data = "{\"on\":false, \"transitiontime\": "+string(info.transitiontime)+"}";
-                    auto response = http.request("put", string{ "/api/" } + username + "/lights/" + string(n + 1) + "/state", post_data);
-                    if (response.status != 200) // !OK
-                    {
-                        LOG(WARNING) << "Failed to set light [" << (n + 1) << "] philips hue bridge: " << response.status;
-                        LOG(WARNING) << response.body;
-                    }
+                    best = n;
+                    best_score = score;
                 }
             }
+            auto response = http.request("put", string{ "/api/" } + username + "/lights/" + string(best + 1) + "/state", targets[best].toJson());
+            if (response.status != 200) // !OK
+            {
+                LOG(WARNING) << "Failed to set light [" << (best + 1) << "] philips hue bridge: " << response.status;
+                LOG(WARNING) << response.body;
+            }
+            sent[best] = targets[best];
+            sent_valid[best] = true;
+            changed_since[best] = {};
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        //Stay within the request budget of the bridge, it drops requests when flooded.
+        std::this_thread::sleep_until(now + request_delay);
     }
 }
@@ -17,6 +17,9 @@
 // Saturation
 // Hue
 // Transition Time
+//Light changes are sent within the request budget of the bridge, most changed lights first.
+//When all lights are set to the same state, a single request to a group of just the configured lights updates them all.
+//The bridge handles group requests a lot slower than light requests, so those are sent at most once per second.
 class PhilipsHueDevice : public HardwareOutputDevice
 {
 public:
@@ -27,6 +30,7 @@ public:
     // Parameter: "ip": IP address of the bridge.
     // Parameter: "username": API username to use. If not set, will request a username from the bridge.
     // Parameter: "userfile": Filename to store the username API in, if not set with the user parameter and username is requested from the bridge.
+    // Parameter: "requests_per_second": Maximum amount of requests sent to the bridge. Default "10", what the bridge handles.
     virtual bool configure(std::unordered_map<string, string> settings) override;
 
     //Set a hardware channel output. Value is 0.0 to 1.0 for no to max output.
@@ -39,14 +43,16 @@ private:
     class LightInfo
     {
     public:
-        LightInfo() : dirty(true), brightness(0), saturation(0), hue(0), transitiontime(0), laststate(0) {}
+        int brightness = 0;
+        int saturation = 0;
+        int hue = 0;
+        int transitiontime = 0;
 
-        bool dirty;
-        int brightness;
-        int saturation;
-        int hue;
-        int transitiontime;
-        string laststate;
+        bool operator==(const LightInfo& other) const { return brightness == other.brightness && saturation == other.saturation && hue == other.hue && transitiontime == other.transitiontime; }
+        bool operator!=(const LightInfo& other) const { return !(*this == other); }
+        //How noticeable a change from the other state is, used to send the most visible changes first.
+        float difference(const LightInfo& other) const;
+        string toJson() const;
     };
 
     std::thread update_thread;
@@ -54,7 +60,9 @@ private:
     std::vector<LightInfo> lights;
 
     bool run_thread;
+    int requests_per_second = 10;
 
+    void setupGroup(const std::vector<string>& light_ids);
     void updateLoop();
 
     string ip_address;
@@ -62,6 +70,9 @@ private:
     string username;
     string userfile;
     int light_count;
+    //Bridge group of the configured lights, empty if it could not be set up.
+    string group_id;
+    std::vector<int> group_lights;
 };
 
 #endif//S_ACN_DMX_DEVICE_H
@@ -4,21 +4,24 @@
 #include "random.h"
 #include "logging.h"
 
+#include <algorithm>
+
 StreamingAcnDMXDevice::StreamingAcnDMXDevice()
 {
-    for(int n=0; n<512; n++)
-        channel_data[n] = 0;
-    channel_count = 512;
+    channel_count = 0;
 
     multicast = false;
-    resend_delay = 50;
+    resend_delay = 800;
 
     universe = 1;
+    sync_universe = 0;
+    sync_sequence_number = 0;
     for(int n=0; n<16; n++)
         uuid[n] = uint8_t(irandom(0, 255));
     memset(source_name, 0, sizeof(source_name));
     strcpy((char*)source_name, "EmptyEpsilon");
     run_thread = false;
+    any_changed = false;
     socket.bind(acn_port - 1);
 }
 
@@ -26,30 +29,62 @@ StreamingAcnDMXDevice::~StreamingAcnDMXDevice()
 {
     if (run_thread)
     {
-        run_thread = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            run_thread = false;
+        }
+        data_changed.notify_one();
         update_thread.join();
     }
 }
 
 bool StreamingAcnDMXDevice::configure(std::unordered_map<string, string> settings)
 {
+    int universe_count = 1;
+    channel_count = universe_size;
     if (settings.find("channels") != settings.end())
     {
-        channel_count = std::max(1, std::min(512, settings["channels"].toInt()));
+        channel_count = std::max(1, std::min(max_universes * universe_size, settings["channels"].toInt()));
+        universe_count = (channel_count + universe_size - 1) / universe_size;
+    }
+    if (settings.find("universes") != settings.end())
+    {
+        universe_count = std::max(1, std::min(max_universes, settings["universes"].toInt()));
+        if (settings.find("channels") == settings.end())
+            channel_count = universe_count * universe_size;
     }
+    channel_count = std::min(channel_count, universe_count * universe_size);
     if (settings.find("universe") != settings.end())
     {
         universe = std::max(1, std::min(63999, settings["universe"].toInt()));
     }
+    universe_count = std::min(universe_count, 63999 - universe + 1);
+    channel_count = std::min(channel_count, universe_count * universe_size);
     if (settings.find("resend_delay") != settings.end())
     {
         resend_delay = std::max(1, settings["resend_delay"].toInt());
     }
+    if (settings.find("sync_universe") != settings.end())
+    {
+        sync_universe = std::max(0, std::min(63999, settings["sync_universe"].toInt()));
+    }
     if (settings.find("multicast") != settings.end())
     {
         multicast = settings["multicast"].toInt() != 0;
     }
 
+    channel_data.assign(channel_count, 0);
+    universes.clear();
+    for(int n=0; n<universe_count; n++)
+    {
+        Universe u;
+        u.number = universe + n;
+        u.first_channel = n * universe_size;
+        u.channel_count = std::min(universe_size, channel_count - u.first_channel);
+        universes.push_back(std::move(u));
+    }
+    buildPackets();
+
     run_thread = true;
     update_thread = std::thread(&StreamingAcnDMXDevice::updateLoop, this);
     return true;
@@ -58,8 +93,21 @@ bool StreamingAcnDMXDevice::configure(std::unordered_map<string, string> setting
 //Set a hardware channel output. Value is 0.0 to 1.0 for no to max output.
 void StreamingAcnDMXDevice::setChannelData(int channel, float value)
 {
-    if (channel >= 0 && channel < channel_count)
-        channel_data[channel] = int((value * 255.0f) + 0.5f);
+    if (channel < 0 || channel >= channel_count)
+        return;
+    uint8_t data = int((value * 255.0f) + 0.5f);
+    bool notify = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (channel_data[channel] == data)
+            return;
+        channel_data[channel] = data;
+        universes[channel / universe_size].changed = true;
+        notify = !any_changed;
+        any_changed = true;
+    }
+    if (notify)
+        data_changed.notify_one();
 }
 
 //Return the number of output channels supported by this device.
@@ -68,52 +116,120 @@ int StreamingAcnDMXDevice::getChannelCount()
     return channel_count;
 }
 
-void StreamingAcnDMXDevice::updateLoop()
+void StreamingAcnDMXDevice::buildPackets()
 {
-    uint8_t sequence_number = 0;
-    while(run_thread)
+    std::vector<uint8_t> buffer;
+    auto addU8 = [&buffer](uint8_t d) { buffer.push_back(d); };
+    auto addU16 = [&buffer](uint16_t d) { buffer.push_back(d >> 8); buffer.push_back(d); };
+    auto addU32 = [&buffer](uint32_t d) { buffer.push_back(d >> 24); buffer.push_back(d >> 16); buffer.push_back(d >> 8); buffer.push_back(d); };
+    auto addRootLayer = [&](uint32_t vector, int packet_size)
     {
-        std::vector<uint8_t> buffer;
-        auto addU8 = [&buffer](uint8_t d) { buffer.resize(buffer.size() + 1); buffer[buffer.size()-1] = d; };
-        auto addU16 = [&buffer](uint16_t d) { buffer.resize(buffer.size() + 2); buffer[buffer.size()-2] = d >> 8; buffer[buffer.size()-1] = d; };
-        auto addU32 = [&buffer](uint16_t d) { buffer.resize(buffer.size() + 4); buffer[buffer.size()-4] = d >> 24; buffer[buffer.size()-3] = d >> 16; buffer[buffer.size()-2] = d >> 8; buffer[buffer.size()-1] = d; };
-
-        //Root layer
         addU16(0x0010); //RLP Size
         addU16(0x0000); //RLP Preamble size
-        addU8('A'); addU8('S'); addU8('C'); addU8('-'); addU8('E'); addU8('1'); addU8('.'); addU8('1'); addU8('7'); addU8('\0'); addU8('\0'); addU8('\0'); //ACN Packet identifier
-        addU16(0x7000 | (110 + channel_count)); //Flags and length
-        addU32(0x0004); //Vector, identifies as PDU protocol
+        for(char c : {'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', '\0', '\0', '\0'}) //ACN Packet identifier
+            addU8(c);
+        addU16(0x7000 | (packet_size - 16)); //Flags and length
+        addU32(vector); //Vector, 0x0004 for data, 0x0008 for extended (synchronization) packets
         for(int n=0; n<16; n++)
             addU8(uuid[n]);//Sender Unique ID, needs to be an UUID by spec. But most likely ignored by equipment.
+    };
+
+    for(auto& u : universes)
+    {
+        int packet_size = data_header_size + u.channel_count;
+        buffer.clear();
+        buffer.reserve(packet_size);
+        addRootLayer(0x0004, packet_size);
         //Framing layer
-        addU16(0x7000 | (88 + channel_count)); //Flags and length
+        addU16(0x7000 | (packet_size - 38)); //Flags and length
         addU32(0x0002); //Vector, identifies as DMP protocol PDU
         for(int n=0; n<64; n++)
             addU8(source_name[n]);//Source name, needs to be an UTF-8 zero terminated string. Only for ID goals.
         addU8(100); //Priority
-        addU16(0);  //Reserved
-        addU8(sequence_number);  //sequence number
+        addU16(sync_universe);  //Synchronization address, 0 for none
+        addU8(0);  //sequence number, patched on every send (offset 111)
         addU8(0);  //option flags
-        addU16(universe);  //Universe number
+        addU16(u.number);  //Universe number
         //DMP layer
-        addU16(0x7000 | (11 + channel_count)); //Flags and length
+        addU16(0x7000 | (packet_size - 115)); //Flags and length
         addU8(2);  //Vector, message is PDU
         addU8(0xa1);  //Format of address and data
         addU16(0x0000);  //First property address
         addU16(0x0001);  //Address increments
-        addU16(1 + channel_count);  //Value count
+        addU16(1 + u.channel_count);  //Value count
         addU8(0x00); //DMX512 start byte.
-        for(int n=0; n<channel_count; n++)
-            addU8(channel_data[n]);
+        buffer.resize(packet_size, 0); //Slot data, patched on every send (offset 126)
+        u.packet = buffer;
+    }
+
+    sync_packet.clear();
+    if (sync_universe)
+    {
+        buffer.clear();
+        addRootLayer(0x0008, sync_packet_size);
+        //Synchronization framing layer
+        addU16(0x7000 | (sync_packet_size - 38)); //Flags and length
+        addU32(0x0001); //Vector, identifies as synchronization packet
+        addU8(0);  //sequence number, patched on every send (offset 44)
+        addU16(sync_universe);  //Synchronization address
+        addU16(0);  //Reserved
+        sync_packet = buffer;
+    }
+}
 
-        sequence_number++;
+void StreamingAcnDMXDevice::send(const std::vector<uint8_t>& packet, int universe_number)
+{
+    if (multicast)
+        socket.sendMulticast(packet.data(), packet.size(), universe_number, acn_port);
+    else
+        socket.sendBroadcast(packet.data(), packet.size(), acn_port);
+}
+
+void StreamingAcnDMXDevice::updateLoop()
+{
+    auto keep_alive = std::chrono::milliseconds(resend_delay);
+    std::vector<Universe*> to_send;
+    std::unique_lock<std::mutex> lock(mutex);
+    while(run_thread)
+    {
+        auto next_send = std::chrono::steady_clock::now() + keep_alive;
+        for(auto& u : universes)
+            next_send = std::min(next_send, u.last_send + keep_alive);
+        data_changed.wait_until(lock, next_send, [this]() { return !run_thread || any_changed; });
+        if (!run_thread)
+            break;
+        if (any_changed)
+        {
+            //The channels of a frame are set one after the other, let the rest of the frame arrive before sending.
+            lock.unlock();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            lock.lock();
+        }
+        any_changed = false;
 
-        if (multicast)
-            socket.sendMulticast(buffer.data(), buffer.size(), universe, acn_port);
-        else
-            socket.sendBroadcast(buffer.data(), buffer.size(), acn_port);
+        auto now = std::chrono::steady_clock::now();
+        to_send.clear();
+        for(auto& u : universes)
+        {
+            if (!u.changed && now - u.last_send < keep_alive)
+                continue;
+            memcpy(&u.packet[data_header_size], &channel_data[u.first_channel], u.channel_count);
+            u.changed = false;
+            u.last_send = now;
+            to_send.push_back(&u);
+        }
+        lock.unlock();
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(resend_delay));
+        for(auto u : to_send)
+        {
+            u->packet[111] = u->sequence_number++;
+            send(u->packet, u->number);
+        }
+        if (!to_send.empty() && !sync_packet.empty())
+        {
+            sync_packet[44] = sync_sequence_number++;
+            send(sync_packet, sync_universe);
+        }
+        lock.lock();
     }
 }
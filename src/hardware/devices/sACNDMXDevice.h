@@ -5,25 +5,53 @@
 #include "hardware/hardwareOutputDevice.h"
 
 #include <stdint.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 //The AcnDMXDevice talks the ACN E1.31 protocol. Which is an UDP protocol for sending DMX messages trough IP networks.
+//A single device drives a range of universes. A universe is sent as soon as its data changes, and otherwise repeated
+//at the keep alive rate. Packets are built once at configuration, only the sequence number and slot data change.
 class StreamingAcnDMXDevice : public HardwareOutputDevice
 {
 private:
     static constexpr int acn_port = 5568;
+    static constexpr int universe_size = 512;
+    static constexpr int max_universes = 64;
+    static constexpr int data_header_size = 126;
+    static constexpr int sync_packet_size = 49;
+
+    struct Universe
+    {
+        int number;
+        int first_channel;
+        int channel_count;
+        uint8_t sequence_number = 0;
+        bool changed = true;
+        std::chrono::steady_clock::time_point last_send;
+        std::vector<uint8_t> packet;
+    };
 
     std::thread update_thread;
+    std::mutex mutex;
+    std::condition_variable data_changed;
     sp::io::network::UdpSocket socket;
 
     bool run_thread;
+    bool any_changed;
     int channel_count;
-    uint8_t channel_data[512];
+    std::vector<uint8_t> channel_data;
+    std::vector<Universe> universes;
 
     int resend_delay;
     bool multicast;
 
     int universe;
+    int sync_universe;
+    uint8_t sync_sequence_number;
+    std::vector<uint8_t> sync_packet;
     uint8_t uuid[16];
     uint8_t source_name[64];
 public:
@@ -31,9 +59,11 @@ public:
     virtual ~StreamingAcnDMXDevice();
 
     //Configure the device.
-    // Parameter: "channels" amount of output channels used (default: 512)
-    // Parameter: "universe" which sACN universe to broadcast in. Default "1"
-    // Parameter: "resend_delay" Time between broadcast packets, in ms. Default "50"
+    // Parameter: "channels" amount of output channels used, spread over the universes in blocks of 512 (default: 512 per universe, at most 64 universes)
+    // Parameter: "universe" which sACN universe to broadcast the first 512 channels in, the others follow in the next universes. Default "1"
+    // Parameter: "universes" amount of universes to send. Default is enough for "channels"
+    // Parameter: "resend_delay" Time between repeats of universes that did not change, in ms. Default "800", the E1.31 keep alive rate
+    // Parameter: "sync_universe" Universe to send E1.31 synchronization packets on, so fixtures in all universes update in lockstep. Default "0", no synchronization
     // Parameter: "multicast" Per default, sACN should be using multicast. But this implementation can also use broadcast. Default is to use broadcast. Set to 1 for multicast.
     virtual bool configure(std::unordered_map<string, string> settings) override;
 
@@ -44,6 +74,8 @@ public:
     virtual int getChannelCount() override;
 
 private:
+    void buildPackets();
+    void send(const std::vector<uint8_t>& packet, int universe_number);
     void updateLoop();
 };
 
@@ -15,6 +15,12 @@
     }
 #endif
 
+UDMXDevice::UDMXDevice()
+{
+    for(int n=0; n<512; n++)
+        channel_data[n] = -1;
+}
+
 //Configure the device.
 bool UDMXDevice::configure(std::unordered_map<string, string> settings)
 {
@@ -67,8 +73,14 @@ bool UDMXDevice::configure(std::unordered_map<string, string> settings)
 //Set a hardware channel output. Value is 0.0 to 1.0 for no to max output.
 void UDMXDevice::setChannelData(int channel, float value)
 {
+    if (channel < 0 || channel >= 512)
+        return;
+    int data = value * 255;
+    if (channel_data[channel] == data)
+        return;
+    channel_data[channel] = data;
 #ifdef _WIN32
-    UDMX_ChannelSet(channel, value * 255);
+    UDMX_ChannelSet(channel, data);
 #endif
 }
 
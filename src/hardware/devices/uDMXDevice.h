@@ -7,8 +7,10 @@
 class UDMXDevice : public HardwareOutputDevice
 {
 private:
+    //Last value given to the driver per channel, -1 when none yet. Every driver call is a USB transfer, so unchanged channels are skipped.
+    int channel_data[512];
 public:
-    UDMXDevice() = default;
+    UDMXDevice();
     virtual ~UDMXDevice() = default;
 
     //Configure the device.
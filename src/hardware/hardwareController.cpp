@@ -196,11 +196,12 @@ void HardwareController::update(float delta)
         return;
     for(float& value : channels)
         value = 0.0;
+    sampleVariables();
     for(HardwareMappingState& state : states)
     {
         float value;
         bool active = false;
-        if (getVariableValue(state.variable, value))
+        if (getSampledValue(state.variable_index, value))
         {
             switch(state.compare_operator)
             {
@@ -222,7 +223,7 @@ void HardwareController::update(float delta)
     {
         float value;
         bool trigger = false;
-        if (getVariableValue(event.trigger_variable, value))
+        if (getSampledValue(event.variable_index, value))
         {
             if (event.previous_valid)
             {
@@ -296,6 +297,7 @@ void HardwareController::createNewHardwareMappingState(int channel_number, std::
         }
     }
 
+    state.variable_index = compileVariable(state.variable);
     state.effect = createEffect(settings);
 
     if (state.effect)
@@ -322,6 +324,7 @@ void HardwareController::createNewHardwareMappingEvent(int channel_number, std::
         trigger = trigger.substr(1).strip();
     }
     event.trigger_variable = trigger;
+    event.variable_index = compileVariable(trigger);
     event.channel_nr = channel_number;
     event.runtime = settings["runtime"].toFloat();
     event.previous_value = 0.0;
@@ -355,73 +358,146 @@ HardwareMappingEffect* HardwareController::createEffect(std::unordered_map<strin
     return nullptr;
 }
 
-#define SHIP_VARIABLE(name, COMP, formula) if (variable_name == name) { if (auto c = ship.getComponent<COMP>()) { value = (formula); return true; } return false; }
-#define SHIP_VARIABLE2(name, formula) if (variable_name == name) { if (c) { value = (formula); return true; } return false; }
-bool HardwareController::getVariableValue(string variable_name, float& value)
+namespace {
+// Everything a variable name can refer to, resolved once when the configuration is loaded.
+struct VariableAccessor
 {
-    auto ship = my_spaceship;
-    if (!ship) {
-        for(auto [entity, pc] : sp::ecs::Query<PlayerControl>()) {
-            ship = entity;
-            break;
-        }
-    }
+    bool (*get)(sp::ecs::Entity ship, int n, float& value);
+    int n;
+    // Spatial queries are too expensive to run for every frame, these are sampled at most once per game tick.
+    bool spatial;
+};
+}
+static std::vector<VariableAccessor> variable_accessors;
+static std::unordered_map<string, int> variable_accessor_index;
 
-    if (variable_name == "Always")
+#define SHIP_VARIABLE_N(name, index, is_spatial, COMP, formula) addVariableAccessor(name, {[](sp::ecs::Entity ship, int n, float& value) { if (auto c = ship.getComponent<COMP>()) { value = (formula); return true; } return false; }, index, is_spatial});
+#define SHIP_VARIABLE(name, COMP, formula) SHIP_VARIABLE_N(name, 0, false, COMP, formula)
+#define SHIP_SYSTEM_VARIABLE(name, index, formula) addVariableAccessor(name, {[](sp::ecs::Entity ship, int n, float& value) { if (auto c = ShipSystem::get(ship, ShipSystem::Type(n))) { value = (formula); return true; } return false; }, index, false});
+static void addVariableAccessor(const string& name, VariableAccessor accessor)
+{
+    variable_accessor_index[name] = int(variable_accessors.size());
+    variable_accessors.push_back(accessor);
+}
+
+static int findVariableAccessor(const string& variable_name)
+{
+    if (variable_accessors.empty())
     {
-        value = 1.0;
-        return true;
+        addVariableAccessor("Always", {[](sp::ecs::Entity ship, int n, float& value) { value = 1.0f; return true; }, 0, false});
+        addVariableAccessor("HasShip", {[](sp::ecs::Entity ship, int n, float& value) { value = bool(ship) ? 1.0f : 0.0f; return true; }, 0, false});
+        SHIP_VARIABLE("Hull", Hull, 100.0f * c->current / c->max);
+        SHIP_VARIABLE("FrontShield", Shields, c->entries.size() > 0 ? c->entries[0].percentage() : 0.0f);
+        SHIP_VARIABLE("RearShield", Shields, c->entries.size() > 1 ? c->entries[1].percentage() : 0.0f);
+        for(int n=0; n<8; n++)
+            SHIP_VARIABLE_N("Shield" + string(n), n, false, Shields, int(c->entries.size()) > n ? c->entries[n].percentage() : 0.0f);
+        SHIP_VARIABLE("Energy", Reactor, c->energy * 100 / c->max_energy);
+        SHIP_VARIABLE("ShieldsUp", Shields, c->active ? 1.0f : 0.0f);
+        SHIP_VARIABLE("ShieldsCalibrating", Shields, c->calibration_delay / c->calibration_time);
+        SHIP_VARIABLE("Impulse", ImpulseEngine, c->actual * c->getSystemEffectiveness());
+        SHIP_VARIABLE("Warp", WarpDrive, c->current * c->getSystemEffectiveness());
+        SHIP_VARIABLE("Docking", DockingPort, c->state == DockingPort::State::Docking ? 1.0f : 0.0f);
+        SHIP_VARIABLE("Docked", DockingPort, c->state == DockingPort::State::Docked ? 1.0f : 0.0f);
+        SHIP_VARIABLE_N("InNebula", 0, true, sp::Transform, RadarBlockSystem::inRadarBlock(c->getPosition()) ? 1.0f : 0.0f);
+        SHIP_VARIABLE_N("IsJammed", 0, true, sp::Transform, WarpSystem::isWarpJammed(ship) ? 1.0f : 0.0f);
+        SHIP_VARIABLE("Jumping", JumpDrive, c->delay > 0.0f ? 1.0f : 0.0f);
+        SHIP_VARIABLE("Jumped", JumpDrive, c->just_jumped > 0.0f ? 1.0f : 0.0f);
+        SHIP_VARIABLE("Alert", PlayerControl, c->alert_level != AlertLevel::Normal ? 1.0f : 0.0f);
+        SHIP_VARIABLE("YellowAlert", PlayerControl, c->alert_level != AlertLevel::YellowAlert ? 1.0f : 0.0f);
+        SHIP_VARIABLE("RedAlert", PlayerControl, c->alert_level != AlertLevel::RedAlert ? 1.0f : 0.0f);
+        SHIP_VARIABLE("SelfDestruct", SelfDestruct, c->active ? 1.0f : 0.0f);
+        SHIP_VARIABLE("SelfDestructCountdown", SelfDestruct, c->countdown / 10.0f);
+        for(int n=0; n<16; n++)
+        {
+            SHIP_VARIABLE_N("TubeLoaded" + string(n), n, false, MissileTubes, int(c->mounts.size()) > n && c->mounts[n].state == MissileTubes::MountPoint::State::Loaded ? 1.0f : 0.0f);
+            SHIP_VARIABLE_N("TubeLoading" + string(n), n, false, MissileTubes, int(c->mounts.size()) > n && c->mounts[n].state == MissileTubes::MountPoint::State::Loading ? 1.0f : 0.0f);
+            SHIP_VARIABLE_N("TubeUnloading" + string(n), n, false, MissileTubes, int(c->mounts.size()) > n && c->mounts[n].state == MissileTubes::MountPoint::State::Unloading ? 1.0f : 0.0f);
+            SHIP_VARIABLE_N("TubeFiring" + string(n), n, false, MissileTubes, int(c->mounts.size()) > n && c->mounts[n].state == MissileTubes::MountPoint::State::Firing ? 1.0f : 0.0f);
+        }
+        for(int n=0; n<ShipSystem::COUNT; n++)
+        {
+            string name = getSystemName(ShipSystem::Type(n)).replace(" ", "");
+            SHIP_SYSTEM_VARIABLE(name + "Health", n, c->health);
+            SHIP_SYSTEM_VARIABLE(name + "Power", n, c->power_level / 3.0f);
+            SHIP_SYSTEM_VARIABLE(name + "Heat", n, c->heat_level);
+            SHIP_SYSTEM_VARIABLE(name + "Coolant", n, c->coolant_level);
+            SHIP_SYSTEM_VARIABLE(name + "Hacked", n, c->hacked_level);
+        }
     }
-    if (variable_name == "HasShip")
+
+    auto it = variable_accessor_index.find(variable_name);
+    if (it == variable_accessor_index.end())
+        return -1;
+    return it->second;
+}
+
+static sp::ecs::Entity getHardwareShip()
+{
+    if (my_spaceship)
+        return my_spaceship;
+    for(auto [entity, pc] : sp::ecs::Query<PlayerControl>())
+        return entity;
+    return {};
+}
+
+bool HardwareController::getVariableValue(string variable_name, float& value)
+{
+    value = 0.0;
+    int index = findVariableAccessor(variable_name);
+    if (index < 0)
     {
-        value = bool(ship) ? 1.0f : 0.0f;
-        return true;
+        LOG(WARNING) << "Unknown variable: " << variable_name;
+        return false;
     }
-    SHIP_VARIABLE("Hull", Hull, 100.0f * c->current / c->max);
-    SHIP_VARIABLE("FrontShield", Shields, c->entries.size() > 0 ? c->entries[0].percentage() : 0.0f);
-    SHIP_VARIABLE("RearShield", Shields, c->entries.size() > 1 ? c->entries[1].percentage() : 0.0f);
-    SHIP_VARIABLE("Shield0", Shields, c->entries.size() > 0 ? c->entries[0].percentage() : 0.0f);
-    SHIP_VARIABLE("Shield1", Shields, c->entries.size() > 1 ? c->entries[1].percentage() : 0.0f);
-    SHIP_VARIABLE("Shield2", Shields, c->entries.size() > 2 ? c->entries[2].percentage() : 0.0f);
-    SHIP_VARIABLE("Shield3", Shields, c->entries.size() > 3 ? c->entries[3].percentage() : 0.0f);
-    SHIP_VARIABLE("Shield4", Shields, c->entries.size() > 4 ? c->entries[4].percentage() : 0.0f);
-    SHIP_VARIABLE("Shield5", Shields, c->entries.size() > 5 ? c->entries[5].percentage() : 0.0f);
-    SHIP_VARIABLE("Shield6", Shields, c->entries.size() > 6 ? c->entries[6].percentage() : 0.0f);
-    SHIP_VARIABLE("Shield7", Shields, c->entries.size() > 7 ? c->entries[7].percentage() : 0.0f);
-    SHIP_VARIABLE("Energy", Reactor, c->energy * 100 / c->max_energy);
-    SHIP_VARIABLE("ShieldsUp", Shields, c->active ? 1.0f : 0.0f);
-    SHIP_VARIABLE("ShieldsCalibrating", Shields, c->calibration_delay / c->calibration_time);
-    SHIP_VARIABLE("Impulse", ImpulseEngine, c->actual * c->getSystemEffectiveness());
-    SHIP_VARIABLE("Warp", WarpDrive, c->current * c->getSystemEffectiveness());
-    SHIP_VARIABLE("Docking", DockingPort, c->state == DockingPort::State::Docking ? 1.0f : 0.0f);
-    SHIP_VARIABLE("Docked", DockingPort, c->state == DockingPort::State::Docked ? 1.0f : 0.0f);
-    SHIP_VARIABLE("InNebula", sp::Transform, RadarBlockSystem::inRadarBlock(c->getPosition()) ? 1.0f : 0.0f);
-    SHIP_VARIABLE("IsJammed", sp::Transform, c && WarpSystem::isWarpJammed(ship) ? 1.0f : 0.0f);
-    SHIP_VARIABLE("Jumping", JumpDrive, c->delay > 0.0f ? 1.0f : 0.0f);
-    SHIP_VARIABLE("Jumped", JumpDrive, c->just_jumped > 0.0f ? 1.0f : 0.0f);
-    SHIP_VARIABLE("Alert", PlayerControl, c->alert_level != AlertLevel::Normal ? 1.0f : 0.0f);
-    SHIP_VARIABLE("YellowAlert", PlayerControl, c->alert_level != AlertLevel::YellowAlert ? 1.0f : 0.0f);
-    SHIP_VARIABLE("RedAlert", PlayerControl, c->alert_level != AlertLevel::RedAlert ? 1.0f : 0.0f);
-    SHIP_VARIABLE("SelfDestruct", SelfDestruct, c->active ? 1.0f : 0.0f);
-    SHIP_VARIABLE("SelfDestructCountdown", SelfDestruct, c->countdown / 10.0f);
-    for(unsigned int n=0; n<16; n++)
+    auto& accessor = variable_accessors[index];
+    return accessor.get(getHardwareShip(), accessor.n, value);
+}
+
+bool HardwareController::isKnownVariable(const string& variable_name)
+{
+    return findVariableAccessor(variable_name) >= 0;
+}
+
+int HardwareController::compileVariable(const string& variable_name)
+{
+    for(unsigned int n=0; n<variables.size(); n++)
+        if (variables[n].name == variable_name)
+            return n;
+    Variable variable;
+    variable.name = variable_name;
+    variable.accessor = findVariableAccessor(variable_name);
+    if (variable.accessor < 0)
+        LOG(WARNING) << "Unknown variable in hardware.ini: " << variable_name;
+    variables.push_back(variable);
+    return int(variables.size()) - 1;
+}
+
+bool HardwareController::getSampledValue(int index, float& value)
+{
+    if (index < 0 || index >= int(variables.size()) || !variables[index].valid)
     {
-        SHIP_VARIABLE("TubeLoaded" + string(n), MissileTubes, c->mounts.size() > n && c->mounts[n].state == MissileTubes::MountPoint::State::Loaded ? 1.0f : 0.0f);
-        SHIP_VARIABLE("TubeLoading" + string(n), MissileTubes, c->mounts.size() > n && c->mounts[n].state == MissileTubes::MountPoint::State::Loading ? 1.0f : 0.0f);
-        SHIP_VARIABLE("TubeUnloading" + string(n), MissileTubes, c->mounts.size() > n && c->mounts[n].state == MissileTubes::MountPoint::State::Unloading ? 1.0f : 0.0f);
-        SHIP_VARIABLE("TubeFiring" + string(n), MissileTubes, c->mounts.size() > n && c->mounts[n].state == MissileTubes::MountPoint::State::Firing ? 1.0f : 0.0f);
+        value = 0.0;
+        return false;
     }
-    for(int n=0; n<ShipSystem::COUNT; n++)
+    value = variables[index].value;
+    return true;
+}
+
+void HardwareController::sampleVariables()
+{
+    auto ship = getHardwareShip();
+    float now = engine->getElapsedTime();
+    bool sample_spatial = now != spatial_sample_time || ship != spatial_sample_ship;
+    spatial_sample_time = now;
+    spatial_sample_ship = ship;
+    for(auto& variable : variables)
     {
-        auto c = ShipSystem::get(ship, static_cast<ShipSystem::Type>(n));
-        SHIP_VARIABLE2(getSystemName(ShipSystem::Type(n)).replace(" ", "") + "Health", c->health);
-        SHIP_VARIABLE2(getSystemName(ShipSystem::Type(n)).replace(" ", "") + "Power", c->power_level / 3.0f);
-        SHIP_VARIABLE2(getSystemName(ShipSystem::Type(n)).replace(" ", "") + "Heat", c->heat_level);
-        SHIP_VARIABLE2(getSystemName(ShipSystem::Type(n)).replace(" ", "") + "Coolant", c->coolant_level);
-        SHIP_VARIABLE2(getSystemName(ShipSystem::Type(n)).replace(" ", "") + "Hacked", c->hacked_level);
+        if (variable.accessor < 0)
+            continue;
+        auto& accessor = variable_accessors[variable.accessor];
+        if (accessor.spatial && !sample_spatial)
+            continue;
+        variable.value = 0.0;
+        variable.valid = accessor.get(ship, accessor.n, variable.value);
     }
-
-    LOG(WARNING) << "Unknown variable: " << variable_name;
-    value = 0.0;
-    return false;
 }
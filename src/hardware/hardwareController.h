@@ -5,6 +5,7 @@
 #include "hardwareOutputDevice.h"
 #include "timer.h"
 #include "Updatable.h"
+#include "ecs/entity.h"
 
 
 class HardwareOutputDevice;
@@ -21,6 +22,7 @@ public:
     };
 
     string variable;
+    int variable_index;
     EOperator compare_operator;
     float compare_value;
     int channel_nr;
@@ -38,6 +40,7 @@ public:
     };
 
     string trigger_variable;
+    int variable_index;
     float runtime;
     sp::Timer timer;
 
@@ -56,6 +59,18 @@ private:
     std::vector<HardwareMappingState> states;
     std::vector<HardwareMappingEvent> events;
     std::vector<float> channels;
+
+    // Every distinct variable used by the configuration, sampled once per frame for all mappings to share.
+    struct Variable
+    {
+        string name;
+        int accessor;
+        float value = 0.0f;
+        bool valid = false;
+    };
+    std::vector<Variable> variables;
+    float spatial_sample_time = -1.0f;
+    sp::ecs::Entity spatial_sample_ship;
 public:
     HardwareController() = default;
     ~HardwareController();
@@ -64,8 +79,14 @@ public:
 
     virtual void update(float delta) override;
 
-    bool getVariableValue(string variable_name, float& value);
+    // Evaluates a variable right away, for occasional use. The configured mappings use the per frame samples.
+    static bool getVariableValue(string variable_name, float& value);
+    static bool isKnownVariable(const string& variable_name);
+    // Index into the per frame samples, resolved when the configuration is loaded.
+    int compileVariable(const string& variable_name);
+    bool getSampledValue(int index, float& value);
 private:
+    void sampleVariables();
     void handleConfig(string section, std::unordered_map<string, string>& settings);
     void createNewHardwareMappingState(int channel_number, std::unordered_map<string, string>& settings);
     void createNewHardwareMappingEvent(int channel_number, std::unordered_map<string, string>& settings);
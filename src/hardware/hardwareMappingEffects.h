@@ -62,6 +62,7 @@ class HardwareMappingEffectVariable : public HardwareMappingEffect
 private:
     HardwareController* controller;
     string variable_name;
+    int variable_index;
     float min_input, max_input;
     float min_output, max_output;
 public:
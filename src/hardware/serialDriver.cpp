@@ -16,6 +16,8 @@
     #include <fcntl.h>
     #include <unistd.h>
     #include <dirent.h>
+    #include <poll.h>
+    #include <errno.h>
 #endif
 #if defined(__APPLE__) && defined(__MACH__)
     #include <IOKit/serial/ioss.h>
@@ -23,6 +25,8 @@
     #include <fcntl.h>
     #include <unistd.h>
     #include <termios.h>
+    #include <poll.h>
+    #include <errno.h>
 
     //Define the IOCTL for OSX that allows you to set a custom serial speed, if it's not defined by one of the includes.
     #ifndef IOSSIOSPEED
@@ -31,6 +35,8 @@
 #endif
 
 #include "serialDriver.h"
+#include <algorithm>
+#include <thread>
 
 SerialPort::SerialPort(string name)
 {
@@ -329,6 +335,32 @@ void SerialPort::send(void* data, int data_size)
 #endif
 }
 
+int SerialPort::trySend(const void* data, int data_size)
+{
+    if (!isOpen())
+        return -1;
+#ifdef _WIN32
+    //Ports are opened without overlapped IO, so this waits for the write like send does.
+    DWORD written = 0;
+    if (!WriteFile(handle, data, data_size, &written, NULL))
+    {
+        COMSTAT comStat;
+        DWORD   dwErrors;
+        ClearCommError(handle, &dwErrors, &comStat);
+        return -1;
+    }
+    return written;
+#endif
+#if defined(__gnu_linux__) || (defined(__APPLE__) && defined(__MACH__))
+    //The port is opened with O_NDELAY, so this never waits.
+    int written = write(handle, data, data_size);
+    if (written < 0)
+        return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+    return written;
+#endif
+    return -1;
+}
+
 int SerialPort::recv(void* data, int data_size)
 {
     if (!isOpen())
@@ -430,6 +462,69 @@ void SerialPort::sendBreak()
 #endif
 }
 
+void SerialPort::sendShortBreak(std::chrono::microseconds duration)
+{
+    if (!isOpen())
+        return;
+#ifdef _WIN32
+    SetCommBreak(handle);
+    std::this_thread::sleep_for(duration);
+    ClearCommBreak(handle);
+#endif
+#if defined(__gnu_linux__) || (defined(__APPLE__) && defined(__MACH__))
+    //Limited, so a port that never drains does not block the caller forever.
+    auto drain_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+    while(getOutputQueueSize() > 0 && std::chrono::steady_clock::now() < drain_deadline)
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    ioctl(handle, TIOCSBRK);
+    std::this_thread::sleep_for(duration);
+    ioctl(handle, TIOCCBRK);
+#endif
+}
+
+int SerialPort::getOutputQueueSize()
+{
+    if (!isOpen())
+        return 0;
+#ifdef _WIN32
+    COMSTAT comStat;
+    DWORD   dwErrors;
+    if (ClearCommError(handle, &dwErrors, &comStat))
+        return comStat.cbOutQue;
+#endif
+#if defined(__gnu_linux__) || (defined(__APPLE__) && defined(__MACH__))
+    int queued = 0;
+    if (ioctl(handle, TIOCOUTQ, &queued) == 0 && queued > 0)
+        return queued;
+#if defined(__gnu_linux__) && defined(TIOCSERGETLSR)
+    //The queue does not include the byte that the UART is still shifting out.
+    unsigned int line_status = 0;
+    if (ioctl(handle, TIOCSERGETLSR, &line_status) == 0 && !(line_status & TIOCSER_TEMT))
+        return 1;
+#endif
+#endif
+    return 0;
+}
+
+void SerialPort::waitWritable(const std::vector<SerialPort*>& ports, std::chrono::microseconds timeout)
+{
+#if defined(__gnu_linux__) || (defined(__APPLE__) && defined(__MACH__))
+    std::vector<struct pollfd> fds;
+    for(auto port : ports)
+    {
+        if (port->isOpen())
+            fds.push_back({port->handle, POLLOUT, 0});
+    }
+    if (!fds.empty())
+    {
+        poll(fds.data(), fds.size(), int(std::max(timeout.count() / 1000, std::chrono::microseconds::rep(1))));
+        return;
+    }
+#endif
+    //Writes on windows always complete, so there is nothing to wait for.
+    std::this_thread::sleep_for(timeout);
+}
+
 std::vector<string> SerialPort::getAvailablePorts()
 {
     std::vector<string> names;
@@ -2,6 +2,7 @@
 #define SERIAL_DRIVER_H
 
 #include "stringImproved.h"
+#include <chrono>
 
 //Class to interact with serial ports. Abstracts the difference between UNIX and Windows API.
 //  And uses some tricks to help identify serial ports.
@@ -38,6 +39,8 @@ public:
     void configure(int baudrate, int databits, EParity parity, EStopBits stopbits);
 
     void send(void* data, int data_size);
+    //Write without waiting for the port. Returns the amount of bytes written, which can be 0 when the port is busy, or -1 on errors.
+    int trySend(const void* data, int data_size);
     int recv(void* data, int data_size);
 
     void setDTR();
@@ -45,6 +48,14 @@ public:
     void setRTS();
     void clearRTS();
     void sendBreak();
+    //Hold the line in break for the given time, for protocols like DMX that need a short break instead of the full character times of sendBreak.
+    //Waits for the data sent before to be transmitted first, as the break would cut it off.
+    void sendShortBreak(std::chrono::microseconds duration);
+    //Amount of bytes written to the port that are not transmitted yet. 0 when the port cannot tell.
+    int getOutputQueueSize();
+
+    //Wait until at least one of the ports can accept more data from trySend, or the timeout passed.
+    static void waitWritable(const std::vector<SerialPort*>& ports, std::chrono::microseconds timeout);
 
     static std::vector<string> getAvailablePorts();
     static string getPseudoDriverName(string port);
@@ -0,0 +1,109 @@
+#include "serialFrameScheduler.h"
+#include "serialDriver.h"
+
+#include <algorithm>
+
+
+SerialFrameScheduler& SerialFrameScheduler::get()
+{
+    static SerialFrameScheduler scheduler;
+    return scheduler;
+}
+
+SerialFrameScheduler::~SerialFrameScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    outputs_changed.notify_one();
+    if (thread.joinable())
+        thread.join();
+}
+
+void SerialFrameScheduler::add(SerialPort* port, FrameBuilder builder, std::chrono::milliseconds frame_delay, std::chrono::milliseconds keep_alive_delay, bool send_break)
+{
+    auto& scheduler = get();
+    {
+        std::lock_guard<std::mutex> lock(scheduler.mutex);
+        Output output;
+        output.port = port;
+        output.builder = std::move(builder);
+        output.frame_delay = std::max(frame_delay, std::chrono::milliseconds(1));
+        output.keep_alive_delay = std::max(keep_alive_delay, frame_delay);
+        output.send_break = send_break;
+        output.next_frame = std::chrono::steady_clock::now();
+        scheduler.outputs.push_back(std::move(output));
+        if (!scheduler.thread.joinable())
+            scheduler.thread = std::thread(&SerialFrameScheduler::run, &scheduler);
+    }
+    scheduler.outputs_changed.notify_one();
+}
+
+void SerialFrameScheduler::remove(SerialPort* port)
+{
+    auto& scheduler = get();
+    std::lock_guard<std::mutex> lock(scheduler.mutex);
+    scheduler.outputs.erase(std::remove_if(scheduler.outputs.begin(), scheduler.outputs.end(), [port](const Output& output) { return output.port == port; }), scheduler.outputs.end());
+}
+
+void SerialFrameScheduler::run()
+{
+    std::vector<SerialPort*> busy_ports;
+    std::unique_lock<std::mutex> lock(mutex);
+    while(!stop)
+    {
+        auto now = std::chrono::steady_clock::now();
+        auto next_wakeup = now + std::chrono::seconds(1);
+        busy_ports.clear();
+        for(auto& output : outputs)
+        {
+            if (output.written >= output.frame.size() && now >= output.next_frame)
+            {
+                //The break would cut off the end of the previous frame, so wait until the port transmitted all of it.
+                //Checked here instead of waiting in sendShortBreak, so a port that is still draining does not hold up the others.
+                if (output.send_break && output.port->getOutputQueueSize() > 0)
+                {
+                    next_wakeup = std::min(next_wakeup, now + std::chrono::milliseconds(1));
+                    continue;
+                }
+                //Keep to the schedule, unless we fell behind by more than a frame, then start over instead of sending a burst.
+                output.next_frame += output.frame_delay;
+                if (output.next_frame < now)
+                    output.next_frame = now + output.frame_delay;
+                bool changed = output.builder(output.frame);
+                if (changed || now - output.last_send >= output.keep_alive_delay)
+                {
+                    output.written = 0;
+                    output.last_send = now;
+                    if (output.send_break)
+                        output.port->sendShortBreak(std::chrono::microseconds(100));
+                }
+                else
+                {
+                    output.written = output.frame.size();
+                }
+            }
+            if (output.written < output.frame.size())
+            {
+                int result = output.port->trySend(output.frame.data() + output.written, int(output.frame.size() - output.written));
+                if (result < 0)
+                    output.written = output.frame.size(); //Write error, drop the frame and try again with the next one.
+                else
+                    output.written += result;
+            }
+            if (output.written < output.frame.size())
+                busy_ports.push_back(output.port);
+            else
+                next_wakeup = std::min(next_wakeup, output.next_frame);
+        }
+
+        auto timeout = std::chrono::duration_cast<std::chrono::microseconds>(next_wakeup - std::chrono::steady_clock::now());
+        if (timeout.count() <= 0)
+            continue;
+        if (!busy_ports.empty())
+            SerialPort::waitWritable(busy_ports, timeout); //Ports are only removed while holding the lock, so keep it.
+        else
+            outputs_changed.wait_until(lock, next_wakeup);
+    }
+}
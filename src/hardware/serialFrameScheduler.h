@@ -0,0 +1,55 @@
+#ifndef SERIAL_FRAME_SCHEDULER_H
+#define SERIAL_FRAME_SCHEDULER_H
+
+#include <stdint.h>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class SerialPort;
+//Sends frames to serial ports for all serial hardware devices, from a single thread.
+//Frames are sent on fixed deadlines instead of sleeping after every send, so the refresh rate does not drift,
+//and writes do not wait for the port, so a slow port does not hold up the others.
+class SerialFrameScheduler
+{
+public:
+    //Called on the scheduler thread to fill in the next frame. Returns false when the data did not change
+    //since the previous frame, the frame is then skipped unless the keep alive delay has passed.
+    using FrameBuilder = std::function<bool(std::vector<uint8_t>& frame)>;
+
+    //Send a frame to the port every frame_delay, or only every keep_alive_delay while nothing changes.
+    //With send_break every frame starts with a DMX break, the frame delay then needs to be longer than it takes to transmit a frame.
+    static void add(SerialPort* port, FrameBuilder builder, std::chrono::milliseconds frame_delay, std::chrono::milliseconds keep_alive_delay, bool send_break);
+    //After this returns the builder of the port is no longer called, and the port can be deleted.
+    static void remove(SerialPort* port);
+
+private:
+    struct Output
+    {
+        SerialPort* port;
+        FrameBuilder builder;
+        std::chrono::steady_clock::duration frame_delay;
+        std::chrono::steady_clock::duration keep_alive_delay;
+        bool send_break;
+        std::chrono::steady_clock::time_point next_frame;
+        std::chrono::steady_clock::time_point last_send;
+        std::vector<uint8_t> frame;
+        size_t written = 0;
+    };
+
+    SerialFrameScheduler() = default;
+    ~SerialFrameScheduler();
+    static SerialFrameScheduler& get();
+    void run();
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable outputs_changed;
+    std::vector<Output> outputs;
+    bool stop = false;
+};
+
+#endif//SERIAL_FRAME_SCHEDULER_H
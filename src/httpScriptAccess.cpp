@@ -1,31 +1,38 @@
 #include "httpScriptAccess.h"
 #include "gameGlobalInfo.h"
 #include "script.h"
+#include "profiler.h"
+#include "hardware/hardwareController.h"
+
+#include <algorithm>
+#include <map>
 
 #define sOBJECT "_OBJECT_"
 
+// Each telemetry expression is evaluated in its own protected call, so one failing expression does not affect the others.
+static string telemetryStatement(const string& expression, size_t index)
+{
+    // The newline keeps a trailing comment in the expression from swallowing the end.
+    return "ok, v = pcall(function() return (" + expression + "\n) end) if ok then r.v" + string(int(index)) + " = v end\n";
+}
+
 
 EEHttpServer::EEHttpServer(int port, string static_file_path)
 : server(port)
 {
     server.setStaticFilePath(static_file_path);
-    server.addURLHandler("/exec.lua", [](const sp::io::http::Server::Request& request) -> string
+    server.addURLHandler("/metrics", [](const sp::io::http::Server::Request& request) -> string
+    {
+        // Prometheus text format, see Profiler for what is measured.
+        return Profiler::getPrometheusText();
+    });
+    server.addURLHandler("/exec.lua", [this](const sp::io::http::Server::Request& request) -> string
     {
         if (!gameGlobalInfo)
             return "{\"ERROR\": \"No game\"}";
-
-        sp::script::Environment env(gameGlobalInfo->script_environment_base.get());
-        setupSubEnvironment(env);
-        auto result = env.run<string>(request.post_data);
-        string output;
-        if (result.isErr()) {
-            output = "{\"ERROR\": \"Script error: " + result.error().replace("\"", "'") + "\"}";
-        } else {
-            output = result.value();
-        }
-        return output;
+        return runScript(request.post_data, false);
     });
-    server.addURLHandler("/get.lua", [](const sp::io::http::Server::Request& request) -> string
+    server.addURLHandler("/get.lua", [this](const sp::io::http::Server::Request& request) -> string
     {
         /*
         Call LUA-exposed functions and return their result in a dictionary.
@@ -37,66 +44,118 @@ EEHttpServer::EEHttpServer(int port, string static_file_path)
         Example Getter: /get.lua?hull=getHull()&nukes=getWeaponStorage("nuke")
         Creates the following LUA-code:
 
-        object = getPlayerShip(-1)
-        if object == nil then return {error = "No valid object"} end
-        return {hull = object:getHull(), nukes = object:getWeaponStorage("nuke"), }
+        local object = getPlayerShip(-1)
+        if object == nil then return toJSON({ERROR = "No valid object"}) end
+        return toJSON({["hull"] = object:getHull(), ["nukes"] = object:getWeaponStorage("nuke"), })
 
-        Returns: {hull = 100, nukes = 42}
+        Returns: {"hull": 100, "nukes": 42}
         */
         if (!gameGlobalInfo)
         {
             return "{\"ERROR\": \"No game\"}";
         }
 
-        /*TODO
-        string luaCode;
-        string objectId = "getPlayerShip(-1)";
-        if (my_spaceship) {
-            int index = gameGlobalInfo->findPlayerShip(my_spaceship);
-            objectId = "getPlayerShip("+std::to_string(index+1)+")";
-        }
-        std::unordered_map<string, string>::const_iterator i;
-        P<ScriptObject> script;
-        string output;
+        string object_id = "getPlayerShip(-1)";
+        auto it = request.query.find(sOBJECT);
+        if (it != request.query.end())
+            object_id = it->second;
 
-        // Look for _OBJECT_ in parameters. If not found, use default
-        i = request.query.find(sOBJECT);
-        if (i != request.query.end())
+        // Sorted, so the same query always results in the same code, and thus the same compiled function.
+        std::map<string, string> getters;
+        for(auto& [key, getter] : request.query)
         {
-            objectId = i->second;
+            if (key == sOBJECT)
+                continue;
+            // Fail if trying to set stuff. We only do get.
+            if (getter.startswith("set"))
+                return "{\"ERROR\": \"Cannot set values through get.lua\", \"COMMAND\": \"" + getter.replace("\"", "'") + "\"}";
+            if (key.find("\"") >= 0 || key.find("\\") >= 0 || key.find("\n") >= 0)
+                return "{\"ERROR\": \"Invalid key\", \"KEY\": \"" + key.replace("\"", "'") + "\"}";
+            getters[key] = getter;
         }
 
-        luaCode = "object = " + objectId + "\n" +
-                  "if object == nil then return {error = \"No valid object\"} end\n" +
-                  "return {";
+        string code = "local object = " + object_id + "\n"
+            "if object == nil then return toJSON({ERROR = \"No valid object\"}) end\n"
+            "return toJSON({";
+        for(auto& [key, getter] : getters)
+            code += "[\"" + key + "\"] = object:" + getter + ", ";
+        code += "})";
+        // Dashboards poll the same values many times per second, within a tick those cannot change.
+        return runScript(code, true);
+    });
+    server.addURLHandler("/subscribe", [this](const sp::io::http::Server::Request& request) -> string
+    {
+        /*
+        Subscribe to variables, for use with /telemetry.
+        POST one variable per line: either a hardware.ini variable name (Hull, Energy, BeamWeaponsHeat, ...)
+        or a Lua expression prefixed with "lua:", evaluated in the same environment as /exec.lua.
 
-        // Loop through URL parameters
-        for (i = request.query.begin(); i != request.query.end(); i++)
+        Example:
+        Hull
+        RedAlert
+        lua:getPlayerShip(-1):getWeaponStorage("homing")
+
+        Returns: {"id": 1}
+        Unknown variables and Lua expressions that do not compile fail the whole subscription.
+        */
+        TelemetrySubscription subscription;
+        for(auto line : request.post_data.split("\n"))
         {
-            if (i->first == sOBJECT)
+            line = line.strip();
+            if (line.empty() || std::find(subscription.variables.begin(), subscription.variables.end(), line) != subscription.variables.end())
                 continue;
-            // Fail if trying to set stuff. We only do get.
-            if (i->second.substr(0, 3) == "set")
+            if (line.startswith("lua:"))
+            {
+                if (!gameGlobalInfo)
+                    return "{\"ERROR\": \"No game\"}";
+                auto error = checkScript("local r, ok, v = {}\n" + telemetryStatement(line.substr(4), 0));
+                if (!error.empty())
+                    return "{\"ERROR\": \"Script error: " + error.replace("\"", "'") + "\", \"VARIABLE\": \"" + line.replace("\"", "'") + "\"}";
+            }
+            else if (!HardwareController::isKnownVariable(line))
             {
-                return "{\"ERROR\": \"Cannot set values through get.lua\", \"COMMAND\": \"" + i->second + "\"}";
+                return "{\"ERROR\": \"Unknown variable\", \"VARIABLE\": \"" + line.replace("\"", "'") + "\"}";
             }
-            // Build LUA-code
-            luaCode += i->first + " = object:" + i->second + ", ";
-        }   luaCode += "}";
+            subscription.variables.push_back(line);
+        }
+        if (subscription.variables.empty())
+            return "{\"ERROR\": \"No variables\"}";
+        for(auto& name : subscription.variables)
+            telemetry_variables[name].subscribers++;
+        subscription.last_poll_time = telemetry_clock.get();
+        int id = ++telemetry_subscription_counter;
+        telemetry_subscriptions[id] = std::move(subscription);
+        return "{\"id\": " + string(id) + "}";
+    });
+    server.addURLHandler("/telemetry", [this](const sp::io::http::Server::Request& request) -> string
+    {
+        /*
+        Values of a subscription that changed since the given sequence number, or all of them when it is left out.
+        Subscriptions that are not polled for 30 seconds are removed.
 
-        // Run script
-        script = new ScriptObject();
-        script->setMaxRunCycles(100000);
+        Syntax: /telemetry?id=1&since=1234
 
-        // Return dictionary with error, else output
-        if (!script->runCode(luaCode, output))
+        Returns: {"sequence": 1240, "values": {"Hull": 87.5}}
+        Pass the returned sequence as since in the next poll.
+        */
+        auto it = request.query.find("id");
+        auto subscription = it != request.query.end() ? telemetry_subscriptions.find(it->second.toInt()) : telemetry_subscriptions.end();
+        if (subscription == telemetry_subscriptions.end())
+            return "{\"ERROR\": \"Unknown subscription\"}";
+        subscription->second.last_poll_time = telemetry_clock.get();
+
+        it = request.query.find("since");
+        int since = it != request.query.end() ? it->second.toInt() : 0;
+        auto result = nlohmann::json::object();
+        auto& values = result["values"] = nlohmann::json::object();
+        for(auto& name : subscription->second.variables)
         {
-            output = "{\"ERROR\": \"Script error\"}";
+            auto& variable = telemetry_variables[name];
+            if (variable.changed_sequence > since)
+                values[name] = variable.value;
         }
-        script->destroy();
-        return output;
-        */
-        return "TODO";
+        result["sequence"] = telemetry_sequence;
+        return result.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
     });
     server.addURLHandler("/set.lua", [](const sp::io::http::Server::Request& request) -> string
     {
@@ -164,3 +223,138 @@ EEHttpServer::EEHttpServer(int port, string static_file_path)
         return "TODO";
     });
 }
+
+void EEHttpServer::prepareEnvironment()
+{
+    // A new scenario comes with a new base environment, anything derived from the old one is invalid.
+    if (!environment || environment_generation != gameGlobalInfo->script_environment_generation)
+    {
+        environment = std::make_unique<sp::script::Environment>(gameGlobalInfo->script_environment_base.get());
+        setupSubEnvironment(*environment);
+        environment_generation = gameGlobalInfo->script_environment_generation;
+        compiled_scripts.clear();
+    }
+}
+
+string EEHttpServer::checkScript(const string& code)
+{
+    prepareEnvironment();
+    // Only defines a local function, so nothing of the code runs.
+    auto res = environment->run<void>("local _ = function()\n" + code + "\nend");
+    if (res.isErr())
+        return res.error();
+    return "";
+}
+
+string EEHttpServer::runScript(const string& code, bool cache_result_for_tick)
+{
+    prepareEnvironment();
+
+    auto it = compiled_scripts.find(code);
+    if (it == compiled_scripts.end())
+    {
+        if (compiled_scripts.size() >= max_compiled_scripts)
+        {
+            auto oldest = std::min_element(compiled_scripts.begin(), compiled_scripts.end(), [](const auto& a, const auto& b) { return a.second.last_used < b.second.last_used; });
+            environment->run<void>(oldest->second.function_name + " = nil");
+            compiled_scripts.erase(oldest);
+        }
+        CompiledScript compiled;
+        compiled.function_name = "_http_script_" + string(++function_counter);
+        // The newline keeps a trailing comment in the code from swallowing the end.
+        auto res = environment->run<void>(compiled.function_name + " = function()\n" + code + "\nend");
+        if (res.isErr())
+            return "{\"ERROR\": \"Script error: " + res.error().replace("\"", "'") + "\"}";
+        it = compiled_scripts.emplace(code, std::move(compiled)).first;
+    }
+
+    auto& compiled = it->second;
+    compiled.last_used = ++use_counter;
+    if (cache_result_for_tick && compiled.result_frame == frame_counter)
+        return compiled.result;
+    auto result = environment->call<string>(compiled.function_name);
+    if (result.isErr())
+        return "{\"ERROR\": \"Script error: " + result.error().replace("\"", "'") + "\"}";
+    compiled.result = result.value();
+    compiled.result_frame = frame_counter;
+    return compiled.result;
+}
+
+void EEHttpServer::update(float delta)
+{
+    frame_counter++;
+    updateTelemetry();
+}
+
+void EEHttpServer::updateTelemetry()
+{
+    // Clients that stopped polling are dropped, so their variables are no longer evaluated.
+    float now = telemetry_clock.get();
+    std::vector<int> expired;
+    for(auto& [id, subscription] : telemetry_subscriptions)
+        if (now - subscription.last_poll_time > telemetry_timeout)
+            expired.push_back(id);
+    for(auto id : expired)
+        removeTelemetrySubscription(id);
+
+    if (telemetry_variables.empty() || !gameGlobalInfo)
+        return;
+
+    telemetry_sequence++;
+    auto setValue = [this](TelemetryVariable& variable, nlohmann::json value)
+    {
+        if (variable.value == value && variable.changed_sequence > 0)
+            return;
+        variable.value = std::move(value);
+        variable.changed_sequence = telemetry_sequence;
+    };
+
+    // All Lua expressions are evaluated with a single script call, each was checked to compile by /subscribe.
+    string code = "local r, ok, v = {}\n";
+    std::vector<TelemetryVariable*> lua_variables;
+    for(auto& [name, variable] : telemetry_variables)
+    {
+        if (name.startswith("lua:"))
+        {
+            code += telemetryStatement(name.substr(4), lua_variables.size());
+            lua_variables.push_back(&variable);
+            continue;
+        }
+        float value;
+        if (HardwareController::getVariableValue(name, value))
+            setValue(variable, value);
+        else
+            setValue(variable, nullptr);
+    }
+    if (lua_variables.empty())
+        return;
+    code += "return toJSON(r)";
+
+    string err;
+    auto result = sp::json::parse(runScript(code, false), err);
+    for(size_t n=0; n<lua_variables.size(); n++)
+    {
+        nlohmann::json value;
+        if (result.has_value() && result.value().is_object())
+        {
+            auto it = result.value().find("v" + std::to_string(n));
+            if (it != result.value().end())
+                value = *it;
+        }
+        setValue(*lua_variables[n], std::move(value));
+    }
+}
+
+void EEHttpServer::removeTelemetrySubscription(int id)
+{
+    auto it = telemetry_subscriptions.find(id);
+    if (it == telemetry_subscriptions.end())
+        return;
+    for(auto& name : it->second.variables)
+    {
+        auto variable = telemetry_variables.find(name);
+        if (variable != telemetry_variables.end() && --variable->second.subscribers <= 0)
+            telemetry_variables.erase(variable);
+    }
+    telemetry_subscriptions.erase(it);
+}
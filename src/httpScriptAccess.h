@@ -2,14 +2,71 @@
 #define HTTP_SCRIPT_ACCESS_H
 
 #include "io/http/server.h"
+#include "io/json.h"
+#include "script/environment.h"
+#include "Updatable.h"
+#include "timer.h"
 
-class EEHttpServer
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class EEHttpServer : public Updatable
 {
 public:
     EEHttpServer(int port, string static_file_path);
 
+    virtual void update(float delta) override;
+
 private:
+    // Runs code in a script environment that is kept between requests. Every distinct piece
+    // of code is compiled into a function of that environment once, and called afterwards.
+    // The least recently used function is dropped when there are too many, globals are kept.
+    string runScript(const string& code, bool cache_result_for_tick);
+    // Compiles the code without running it, returns the error or an empty string.
+    string checkScript(const string& code);
+    void prepareEnvironment();
+
+    struct CompiledScript
+    {
+        string function_name;
+        int last_used = 0;
+        int result_frame = -1;
+        string result;
+    };
+
+    // Telemetry: clients subscribe to a set of variables, which are evaluated once per tick no matter
+    // how many clients subscribed to them. A poll only returns the values changed since the previous poll.
+    struct TelemetryVariable
+    {
+        nlohmann::json value;
+        int changed_sequence = 0;
+        int subscribers = 0;
+    };
+    struct TelemetrySubscription
+    {
+        std::vector<string> variables;
+        float last_poll_time = 0.0f;
+    };
+    void updateTelemetry();
+    void removeTelemetrySubscription(int id);
+
     sp::io::http::Server server;
+    std::unique_ptr<sp::script::Environment> environment;
+    int environment_generation = 0;
+    int function_counter = 0;
+    int use_counter = 0;
+    // Counts update() calls, unlike the elapsed time it also advances while the game is paused.
+    int frame_counter = 0;
+    std::unordered_map<string, CompiledScript> compiled_scripts;
+    static constexpr size_t max_compiled_scripts = 256;
+
+    std::unordered_map<string, TelemetryVariable> telemetry_variables;
+    std::unordered_map<int, TelemetrySubscription> telemetry_subscriptions;
+    int telemetry_subscription_counter = 0;
+    int telemetry_sequence = 0;
+    sp::SystemStopwatch telemetry_clock;
+    static constexpr float telemetry_timeout = 30.0f;
 };
 
 #endif//HTTP_SCRIPT_ACCESS_H
@@ -40,6 +40,7 @@
 #include "multiplayer/zone.h"
 
 #include "systems/ai.h"
+#include "systems/faction.h"
 #include "systems/docking.h"
 #include "systems/comms.h"
 #include "systems/impulse.h"
@@ -67,8 +68,31 @@
 #include "systems/gm.h"
 #include "systems/pickup.h"
 #include "systems/debugrender.h"
+#include "profiler.h"
+#include "simulationClock.h"
 
 
+// Registers the system with its update timed by the profiler, and stepped by the SimulationClock when one runs.
+template<class T> class ProfiledSystem : public T
+{
+public:
+    static inline const char* name = "";
+
+    void update(float delta) override
+    {
+        Profiler::Scope scope(section);
+        T::update(SimulationClock::tickDelta(delta));
+    }
+private:
+    Profiler::Section* section = Profiler::getSection("system", name);
+};
+
+template<class T> static void registerProfiledSystem(const char* name)
+{
+    ProfiledSystem<T>::name = name;
+    engine->registerSystem<ProfiledSystem<T>>();
+}
+
 void initSystemsAndComponents()
 {
     sp::ecs::MultiplayerReplication::registerComponentReplication<BeamWeaponSysReplication>();
@@ -132,40 +156,41 @@ void initSystemsAndComponents()
     sp::ecs::MultiplayerReplication::registerComponentReplication<sp::multiplayer::TransformReplication>();
     sp::ecs::MultiplayerReplication::registerComponentReplication<sp::multiplayer::PhysicsReplication>();
 
-    engine->registerSystem<AISystem>();
-    engine->registerSystem<DamageSystem>();
-    engine->registerSystem<EnergySystem>();
-    engine->registerSystem<DockingSystem>();
-    engine->registerSystem<CommsSystem>();
-    engine->registerSystem<JumpSystem>(); // must be before impulse/warp
-    engine->registerSystem<ImpulseSystem>();
-    engine->registerSystem<ManeuveringSystem>();
-    engine->registerSystem<WarpSystem>();
-    engine->registerSystem<BeamWeaponSystem>();
-    engine->registerSystem<MissileSystem>();
-    engine->registerSystem<ShieldSystem>();
-    engine->registerSystem<CoolantSystem>();
-    engine->registerSystem<ShipSystemsSystem>();
-    engine->registerSystem<SelfDestructSystem>();
-    engine->registerSystem<SfxSystem>();
-    engine->registerSystem<BasicMovementSystem>();
-    engine->registerSystem<GravitySystem>();
-    engine->registerSystem<InternalCrewSystem>();
-    engine->registerSystem<PathFindingSystem>();
-    engine->registerSystem<NebulaRenderSystem>();
-    engine->registerSystem<ExplosionRenderSystem>();
-    engine->registerSystem<BillboardRenderSystem>();
-    engine->registerSystem<PlanetRenderSystem>();
-    engine->registerSystem<PlanetTransparentRenderSystem>();
-    engine->registerSystem<MeshRenderSystem>();
-    engine->registerSystem<ScanningSystem>();
-    engine->registerSystem<BasicRadarRendering>();
-    engine->registerSystem<RadarBlockSystem>();
-    engine->registerSystem<ZoneSystem>();
-    engine->registerSystem<GMRadarRender>();
-    engine->registerSystem<PickupSystem>();
+    registerProfiledSystem<FactionSystem>("FactionSystem"); // must be before anything that checks faction relations
+    registerProfiledSystem<AISystem>("AISystem");
+    registerProfiledSystem<DamageSystem>("DamageSystem");
+    registerProfiledSystem<EnergySystem>("EnergySystem");
+    registerProfiledSystem<DockingSystem>("DockingSystem");
+    registerProfiledSystem<CommsSystem>("CommsSystem");
+    registerProfiledSystem<JumpSystem>("JumpSystem"); // must be before impulse/warp
+    registerProfiledSystem<ImpulseSystem>("ImpulseSystem");
+    registerProfiledSystem<ManeuveringSystem>("ManeuveringSystem");
+    registerProfiledSystem<WarpSystem>("WarpSystem");
+    registerProfiledSystem<BeamWeaponSystem>("BeamWeaponSystem");
+    registerProfiledSystem<MissileSystem>("MissileSystem");
+    registerProfiledSystem<ShieldSystem>("ShieldSystem");
+    registerProfiledSystem<CoolantSystem>("CoolantSystem");
+    registerProfiledSystem<ShipSystemsSystem>("ShipSystemsSystem");
+    registerProfiledSystem<SelfDestructSystem>("SelfDestructSystem");
+    registerProfiledSystem<SfxSystem>("SfxSystem");
+    registerProfiledSystem<BasicMovementSystem>("BasicMovementSystem");
+    registerProfiledSystem<GravitySystem>("GravitySystem");
+    registerProfiledSystem<InternalCrewSystem>("InternalCrewSystem");
+    registerProfiledSystem<PathFindingSystem>("PathFindingSystem");
+    registerProfiledSystem<NebulaRenderSystem>("NebulaRenderSystem");
+    registerProfiledSystem<ExplosionRenderSystem>("ExplosionRenderSystem");
+    registerProfiledSystem<BillboardRenderSystem>("BillboardRenderSystem");
+    registerProfiledSystem<PlanetRenderSystem>("PlanetRenderSystem");
+    registerProfiledSystem<PlanetTransparentRenderSystem>("PlanetTransparentRenderSystem");
+    registerProfiledSystem<MeshRenderSystem>("MeshRenderSystem");
+    registerProfiledSystem<ScanningSystem>("ScanningSystem");
+    registerProfiledSystem<BasicRadarRendering>("BasicRadarRendering");
+    registerProfiledSystem<RadarBlockSystem>("RadarBlockSystem");
+    registerProfiledSystem<ZoneSystem>("ZoneSystem");
+    registerProfiledSystem<GMRadarRender>("GMRadarRender");
+    registerProfiledSystem<PickupSystem>("PickupSystem");
 #ifdef DEBUG
-    engine->registerSystem<DebugRenderSystem>();
+    registerProfiledSystem<DebugRenderSystem>("DebugRenderSystem");
 #endif
     initComponentScriptBindings();
 }
@@ -29,6 +29,10 @@
 #include "init/displaywindows.h"
 #include "init/ecs.h"
 #include "stdinLuaConsole.h"
+#include "simulationClock.h"
+#ifdef EE_BENCHMARK
+#include "tools/benchmark.h"
+#endif
 
 #include "graphics/opengl.h"
 
@@ -43,6 +47,7 @@
 
 #include "shaderRegistry.h"
 #include "glObjects.h"
+#include "mesh.h"
 
 glm::vec3 camera_position;
 float camera_yaw;
@@ -106,6 +111,9 @@ int main(int argc, char** argv)
     initSystemsAndComponents();
 
     auto configuration_path = initConfiguration(argc, argv);
+#ifdef EE_BENCHMARK
+    setupBenchmark();
+#endif
 
     if (PreferencesManager::get("headless") == "")
     {
@@ -141,6 +149,8 @@ int main(int argc, char** argv)
     }
 
     initResourcePaths();
+    if (PreferencesManager::get("headless") == "")
+        Mesh::setCacheDirectory(configuration_path + "/meshcache");
     textureManager.setDefaultSmooth(true);
     textureManager.setDefaultRepeated(true);
     i18n::load("locale/main." + PreferencesManager::get("language", "en") + ".po");
@@ -332,6 +342,17 @@ void returnToMainMenu(RenderLayer* render_layer)
         if (PreferencesManager::get("headless_internet") == "1") game_server->registerOnMasterServer(PreferencesManager::get("registry_registration_url", "http://daid.eu/ee/register.php"));
         gameGlobalInfo->startScenario(headless, loadScenarioSettingsFromPrefs());
 
+        // Faster than real time simulation, for unattended runs.
+        static bool simulation_clock_created = false;
+        float tick_rate = PreferencesManager::get("headless_tick_rate", "0").toFloat();
+        float time_warp = PreferencesManager::get("headless_time_warp", "1").toFloat();
+        if (!simulation_clock_created && (tick_rate > 0.0f || time_warp != 1.0f))
+        {
+            LOG(Info, "Simulating at ", tick_rate > 0.0f ? tick_rate : 60.0f, " ticks per second, up to ", time_warp, " times real time");
+            new SimulationClock(tick_rate, time_warp);
+            simulation_clock_created = true;
+        }
+
         if (PreferencesManager::get("startpaused") != "1")
             engine->setGameSpeed(1.0);
     }
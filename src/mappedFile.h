@@ -0,0 +1,28 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include "nonCopyable.h"
+#include "stringImproved.h"
+#include <cstdint>
+
+// Read-only memory mapping of a whole file. isOpen() is false when the file could not be mapped.
+class MappedFile : sp::NonCopyable
+{
+public:
+    explicit MappedFile(const string& filename);
+    ~MappedFile();
+
+    bool isOpen() const { return data_ptr != nullptr; }
+    const uint8_t* data() const { return data_ptr; }
+    size_t size() const { return data_size; }
+
+private:
+    const uint8_t* data_ptr = nullptr;
+    size_t data_size = 0;
+#ifdef _WIN32
+    void* file_handle = nullptr;
+    void* mapping_handle = nullptr;
+#endif
+};
+
+#endif//MAPPED_FILE_H
@@ -2,6 +2,7 @@
 
 #include "featureDefs.h"
 #include "glObjects.h"
+#include "assetLoader.h"
 #include "soundManager.h"
 #include "random.h"
 #include "multiplayer_client.h"
@@ -142,6 +143,9 @@ ShipSelectionScreen::ShipSelectionScreen()
     // views. As soon as a 3D view is rendered, positional sound is re-enabled.
     soundManager->disablePositionalSound();
 
+    // Load the ship models while the crew is still picking positions, instead of when they first come into view.
+    AssetLoader::prefetchModelData("model_data.lua");
+
     // Draw a container with two columns.
     const int column_width = 550;
     container = new GuiElement(this, "MAIN_CONTAINER");
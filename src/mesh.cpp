@@ -1,67 +1,84 @@
 #include <graphics/opengl.h>
 #include <unordered_map>
-#include <SDL_endian.h>
-#include <meshoptimizer.h>
-#include <glm/gtx/norm.hpp>
+#include <cstdio>
+#include <thread>
+#if !defined(ANDROID)
+#include <filesystem>
+#endif
 
 #include "resources.h"
 #include "random.h"
 #include "mesh.h"
+#include "mappedFile.h"
 
 
-struct ModelDataVertex
+namespace
 {
-    float position[3];
-    float normal[3];
-    float uv[2];
-};
+    constexpr uint32_t NO_BUFFER = 0;
+    std::unordered_map<string, Mesh*> meshMap;
+    string cache_directory;
 
+    string cacheFilename(const string& filename)
+    {
+        return cache_directory + "/" + filename.replace("/", "_").replace("\\", "_") + ".mesh";
+    }
 
-namespace
-{
-    inline int32_t readInt(const P<ResourceStream>& stream)
+    bool loadBinary(const string& filename, P<ResourceStream> stream, uint64_t source_key, MeshData& data)
     {
-        int32_t ret = 0;
-        stream->read(&ret, sizeof(int32_t));
-        return SDL_SwapBE32(ret);
+        // A preprocessed mesh can be shipped next to the source, see the EmptyEpsilonMeshConverter target.
+        if (stream)
+        {
+            std::vector<uint8_t> buffer(stream->getSize());
+            buffer.resize(stream->read(buffer.data(), buffer.size()));
+            if (data.readBinary(buffer.data(), buffer.size(), source_key))
+                return true;
+            LOG(WARNING) << filename << ".mesh is outdated, ignoring it.";
+        }
+        if (cache_directory.empty())
+            return false;
+        MappedFile file(cacheFilename(filename));
+        return file.isOpen() && data.readBinary(file.data(), file.size(), source_key);
     }
 
-    constexpr uint32_t NO_BUFFER = 0;
-    std::unordered_map<string, Mesh*> meshMap;
+    void storeBinary(const string& filename, uint64_t source_key, const MeshData& data)
+    {
+        if (cache_directory.empty())
+            return;
+        auto buffer = data.writeBinary(source_key);
+        // Write to a temporary file first, so a running client never maps a partially written file.
+        // The temporary name is per thread, as a background load can race a synchronous one.
+        auto target = cacheFilename(filename);
+        auto temp = target + ".tmp" + string(int(std::hash<std::thread::id>{}(std::this_thread::get_id()) & 0xFFFF));
+        FILE* f = fopen(temp.c_str(), "wb");
+        if (!f)
+            return;
+        bool ok = fwrite(buffer.data(), 1, buffer.size(), f) == buffer.size();
+        ok = fclose(f) == 0 && ok;
+        if (ok && std::rename(temp.c_str(), target.c_str()) != 0)
+        {
+            // Windows does not replace existing files on rename.
+            std::remove(target.c_str());
+            ok = std::rename(temp.c_str(), target.c_str()) == 0;
+        }
+        if (!ok)
+            std::remove(temp.c_str());
+    }
 }
 
 Mesh::Mesh(std::vector<MeshVertex>&& unindexed_vertices)
-    :face_count{ static_cast<uint32_t>(unindexed_vertices.size()) / 3}
+    : Mesh(MeshData::build(std::move(unindexed_vertices)))
+{
+}
+
+Mesh::Mesh(MeshData&& data)
+    : vertices(std::move(data.vertices)), indices(std::move(data.indices))
 {
-    if (!unindexed_vertices.empty())
+    greatest_distance_from_center = data.greatest_distance_from_center;
+    face_count = static_cast<uint32_t>(indices.empty() ? vertices.size() / 3 : indices.size() / 3);
+    if (!vertices.empty())
     {
         vbo_ibo = gl::Buffers<2>{};
 
-        auto index_count = 3 * face_count;
-        std::vector<uint32_t> remap_indices;
-        {
-            std::vector<uint32_t> remap(index_count); // allocate temporary memory for the remap table
-            vertices.resize(meshopt_generateVertexRemap(remap.data(), nullptr, index_count, unindexed_vertices.data(), index_count, sizeof(MeshVertex)));
-
-            remap_indices.resize(index_count * sizeof(uint32_t));
-            meshopt_remapIndexBuffer(reinterpret_cast<uint32_t*>(remap_indices.data()), nullptr, index_count, remap.data());
-            meshopt_remapVertexBuffer(vertices.data(), unindexed_vertices.data(), index_count, sizeof(MeshVertex), remap.data());
-
-            if (vertices.size() > size_t{ std::numeric_limits<uint16_t>::max() })
-            {
-                // ES 2 only supports u16 for indices - u32 is only available through an extension
-                // (a lot of systems should have it, but SP doesn't have support for it yet).
-                // Forego the indices, and inform the user.
-                vertices = std::move(unindexed_vertices);
-                LOG(WARNING) << "Loading mesh with a large number of vertices (" << vertices.size() << ").";
-            }
-            else
-            {
-                indices.assign(std::begin(remap_indices), std::end(remap_indices));
-                unindexed_vertices.clear();
-            }
-        }
-
         glBindBuffer(GL_ARRAY_BUFFER, vbo_ibo[0]);
         glBufferData(GL_ARRAY_BUFFER, sizeof(MeshVertex) * vertices.size(), vertices.data(), GL_STATIC_DRAW);
         glBindBuffer(GL_ARRAY_BUFFER, GL_NONE);
@@ -69,11 +86,9 @@ Mesh::Mesh(std::vector<MeshVertex>&& unindexed_vertices)
         if (!indices.empty())
         {
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbo_ibo[1]);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_count * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_NONE);
         }
-
-        greatest_distance_from_center = greatestDistanceFromCenter(vertices);
     }
 }
 
@@ -149,217 +164,60 @@ glm::vec3 Mesh::randomPoint()
     return ret;
 }
 
-float Mesh::greatestDistanceFromCenter(std::vector<MeshVertex>& vertices)
-{
-    if (vertices.empty()) {
-        return 0;
-    }
-
-    glm::vec3 sum{};
-    for(auto vertex : vertices) sum += glm::vec3{vertex.position[0], vertex.position[1], vertex.position[2]};
-    auto average = sum / float(vertices.size());
-
-    auto greatest_distance = 0.f;
-    for(auto vertex : vertices)
-    {
-        float distance = glm::distance(average, glm::vec3{vertex.position[0], vertex.position[1], vertex.position[2]});
-        if(distance > greatest_distance) {
-            greatest_distance = distance;
-        }
-    }
-    return greatest_distance;
-}
-
-struct IndexInfo
-{
-    int v;
-    int t;
-    int n;
-};
-
 Mesh* Mesh::getMesh(const string& filename)
 {
-    Mesh* ret = meshMap[filename];
+    Mesh* ret = findMesh(filename);
     if (ret)
         return ret;
 
-    P<ResourceStream> stream = getResourceStream(filename);
-    if (!stream)
+    MeshData data;
+    if (!loadData(filename, getResourceStream(filename), getResourceStream(filename + ".mesh"), data))
         return NULL;
+    return addMesh(filename, std::move(data));
+}
 
-    std::vector<MeshVertex> mesh_vertices;
-    if (filename.endswith(".obj"))
-    {
-        bool parsing_ok = true;
-        std::vector<glm::vec3> vertices;
-        std::vector<glm::vec3> normals;
-        std::vector<glm::vec2> texCoords;
-        std::vector<IndexInfo> indices;
-
-        do
-        {
-            string line = stream->readLine();
-            if (line.length() > 0 && line[0] != '#')
-            {
-                std::vector<string> parts = line.strip().split();
-                if (parts.size() < 1)
-                    continue;
-                if (parts[0] == "v")
-                {
-                    if (parts.size() >= 4)
-                    {
-                        vertices.emplace_back(parts[1].toFloat(), parts[2].toFloat(), parts[3].toFloat());
-                    }
-                    else
-                    {
-                        LOG(ERROR, "Bad vertex line: ", line);
-                        parsing_ok = false;
-                    }
-
-                }else if (parts[0] == "vn")
-                {
-                    if (parts.size() >= 4)
-                    {
-                        normals.push_back(glm::normalize(glm::vec3(parts[1].toFloat(), parts[2].toFloat(), parts[3].toFloat())));
-                    }
-                    else
-                    {
-                        LOG(ERROR, "Bad normal line: ", line);
-                        parsing_ok = false;
-                    }
-
-                }else if (parts[0] == "vt")
-                {
-                    if (parts.size() >= 3)
-                    {
-                        texCoords.push_back(glm::vec2(parts[1].toFloat(), parts[2].toFloat()));
-                    }
-                    else
-                    {
-                        LOG(ERROR, "Bad vertex texcoord line: ", line);
-                        parsing_ok = false;
-                    }
-
-                }else if (parts[0] == "f")
-                {
-                    if (parts.size() >= 4)
-                    {
-                        for (unsigned int n = 3; parsing_ok && n < parts.size(); n++)
-                        {
-                            std::vector<string> p0 = parts[1].split("/");
-                            std::vector<string> p1 = parts[n].split("/");
-                            std::vector<string> p2 = parts[n - 1].split("/");
-
-                            if (p0.size() == 3 && p1.size() == 3 && p2.size() == 3)
-                            {
-                                IndexInfo info;
-                                info.v = p0[0].toInt() - 1;
-                                info.t = p0[1].toInt() - 1;
-                                info.n = p0[2].toInt() - 1;
-                                indices.push_back(info);
-                                info.v = p2[0].toInt() - 1;
-                                info.t = p2[1].toInt() - 1;
-                                info.n = p2[2].toInt() - 1;
-                                indices.push_back(info);
-                                info.v = p1[0].toInt() - 1;
-                                info.t = p1[1].toInt() - 1;
-                                info.n = p1[2].toInt() - 1;
-                                indices.push_back(info);
-                            }
-                            else
-                            {
-                                LOG(ERROR, "Bad face triangle: ", line);
-                                parsing_ok = false;
-                            }
-                        }
-                    }
-                    else
-                    {
-                        LOG(ERROR, "Bad face line: ", line);
-                        parsing_ok = false;
-                    }
-                }else{
-                    LOG(DEBUG, "mesh: ignored: ", line);
-                }
-            }
-        }while(parsing_ok && stream->tell() < stream->getSize());
-
-        if (parsing_ok)
-        {
-            mesh_vertices.resize(indices.size());
-            for (unsigned int n = 0; n < indices.size(); n++)
-            {
-                mesh_vertices[n].position[0] = vertices[indices[n].v].x;
-                mesh_vertices[n].position[1] = vertices[indices[n].v].z;
-                mesh_vertices[n].position[2] = vertices[indices[n].v].y;
-                mesh_vertices[n].normal[0] = normals[indices[n].n].x;
-                mesh_vertices[n].normal[1] = normals[indices[n].n].z;
-                mesh_vertices[n].normal[2] = normals[indices[n].n].y;
-                mesh_vertices[n].uv[0] = texCoords[indices[n].t].x;
-                mesh_vertices[n].uv[1] = 1.f - texCoords[indices[n].t].y;
-            }
-        }
-        else
-        {
-            LOG(ERROR, "Failed to parse ", filename);
-        }
+Mesh* Mesh::findMesh(const string& filename)
+{
+    auto it = meshMap.find(filename);
+    if (it == meshMap.end())
+        return NULL;
+    return it->second;
+}
 
+bool Mesh::loadData(const string& filename, P<ResourceStream> stream, P<ResourceStream> binary_stream, MeshData& data)
+{
+    if (!stream)
+        return false;
 
-    }else if (filename.endswith(".model"))
+    auto source_key = MeshData::sourceKey(stream);
+    if (!loadBinary(filename, binary_stream, source_key, data))
     {
-        std::vector<ModelDataVertex> model_data_vertices;
-        model_data_vertices.resize(readInt(stream));
-        stream->read(model_data_vertices.data(), sizeof(ModelDataVertex) * model_data_vertices.size());
-        mesh_vertices.resize(model_data_vertices.size());
-        for(auto idx=0U; idx<model_data_vertices.size(); idx++) {
-            mesh_vertices[idx].position[0] = model_data_vertices[idx].position[0];
-            mesh_vertices[idx].position[1] = model_data_vertices[idx].position[1];
-            mesh_vertices[idx].position[2] = model_data_vertices[idx].position[2];
-            mesh_vertices[idx].normal[0] = model_data_vertices[idx].normal[0];
-            mesh_vertices[idx].normal[1] = model_data_vertices[idx].normal[1];
-            mesh_vertices[idx].normal[2] = model_data_vertices[idx].normal[2];
-            mesh_vertices[idx].uv[0] = model_data_vertices[idx].uv[0];
-            mesh_vertices[idx].uv[1] = model_data_vertices[idx].uv[1];
-        }
-    }else{
-        LOG(ERROR) << "Unknown mesh format: " << filename;
+        data = MeshData::build(MeshData::parseSource(stream, filename));
+        if (data.vertices.empty())
+            return false;
+        storeBinary(filename, source_key, data);
     }
+    return true;
+}
 
-    if (!mesh_vertices.empty())
-    {
-        // Calculate tangent
-        for(auto idx=0U; idx<mesh_vertices.size(); idx+=3) {
-            auto p0 = glm::vec3(mesh_vertices[idx+0].position[0], mesh_vertices[idx+0].position[1], mesh_vertices[idx+0].position[2]);
-            auto p1 = glm::vec3(mesh_vertices[idx+1].position[0], mesh_vertices[idx+1].position[1], mesh_vertices[idx+1].position[2]);
-            auto p2 = glm::vec3(mesh_vertices[idx+2].position[0], mesh_vertices[idx+2].position[1], mesh_vertices[idx+2].position[2]);
-            auto uv0 = glm::vec2(mesh_vertices[idx+0].uv[0], mesh_vertices[idx+0].uv[1]);
-            auto uv1 = glm::vec2(mesh_vertices[idx+1].uv[0], mesh_vertices[idx+1].uv[1]);
-            auto uv2 = glm::vec2(mesh_vertices[idx+2].uv[0], mesh_vertices[idx+2].uv[1]);
-
-            glm::vec3 edge1 = p1 - p0;
-            glm::vec3 edge2 = p2 - p0;
-            glm::vec2 deltaUV1 = uv1 - uv0;
-            glm::vec2 deltaUV2 = uv2 - uv0;
-
-            float f = 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y);
-
-            auto tangent = glm::vec3(
-                    f * (deltaUV2.y * edge1.x - deltaUV1.y * edge2.x),
-                    f * (deltaUV2.y * edge1.y - deltaUV1.y * edge2.y),
-                    f * (deltaUV2.y * edge1.z - deltaUV1.y * edge2.z));
-
-            for(int n=0; n<3; n++) {
-                mesh_vertices[idx+n].tangent[0] = tangent.x;
-                mesh_vertices[idx+n].tangent[1] = tangent.y;
-                mesh_vertices[idx+n].tangent[2] = tangent.z;
-            }
-        }
-
+Mesh* Mesh::addMesh(const string& filename, MeshData&& data)
+{
+    Mesh*& ret = meshMap[filename];
+    if (!ret)
+        ret = new Mesh(std::move(data));
+    return ret;
+}
 
-        ret = new Mesh(std::move(mesh_vertices));
-        meshMap[filename] = ret;
+void Mesh::setCacheDirectory(const string& directory)
+{
+#if !defined(ANDROID)
+    std::error_code error_code;
+    std::filesystem::create_directories(directory.c_str(), error_code);
+    if (error_code)
+    {
+        LOG(WARNING) << "Cannot create mesh cache directory " << directory << ": " << error_code.message();
+        return;
     }
-
-
-    return ret;
+    cache_directory = directory;
+#endif
 }
@@ -4,17 +4,10 @@
 #include "nonCopyable.h"
 #include "stringImproved.h"
 #include "glObjects.h"
+#include "meshData.h"
 
 #include <glm/vec3.hpp>
 
-struct MeshVertex
-{
-    float position[3];
-    float normal[3];
-    float uv[2];
-    float tangent[3];
-};
-
 class Mesh : sp::NonCopyable
 {
     std::vector<MeshVertex> vertices;
@@ -24,15 +17,21 @@ class Mesh : sp::NonCopyable
 public:
     float greatest_distance_from_center{};
     explicit Mesh(std::vector<MeshVertex>&& vertices);
+    explicit Mesh(MeshData&& data);
 
     void render(int32_t position_attrib, int32_t texcoords_attrib, int32_t normal_attrib, int32_t tangent_attrib);
     glm::vec3 randomPoint();
 
-    // Calculate the center all vertices in this mesh, and return the distance
-    // of the point farthest from that center.
-    float greatestDistanceFromCenter(std::vector<MeshVertex>& vertices);
-
     static Mesh* getMesh(const string& filename);
+    // Split version of getMesh for background loading. loadData takes the already opened source and
+    // preprocessed (filename + ".mesh", may be null) streams. It does not touch OpenGL or the resource
+    // providers and can run on any thread, addMesh uploads the result and must run on the render thread.
+    static Mesh* findMesh(const string& filename);
+    static bool loadData(const string& filename, P<ResourceStream> stream, P<ResourceStream> binary_stream, MeshData& data);
+    static Mesh* addMesh(const string& filename, MeshData&& data);
+
+    // Directory to store preprocessed meshes in, so they only need to be processed once.
+    static void setCacheDirectory(const string& directory);
 };
 
 #endif//MESH_H
@@ -0,0 +1,330 @@
+#include <cstring>
+#include <limits>
+#include <SDL_endian.h>
+#include <meshoptimizer.h>
+#include <glm/gtx/norm.hpp>
+
+#include "meshData.h"
+
+
+struct ModelDataVertex
+{
+    float position[3];
+    float normal[3];
+    float uv[2];
+};
+
+struct IndexInfo
+{
+    int v;
+    int t;
+    int n;
+};
+
+namespace
+{
+    inline int32_t readInt(const P<ResourceStream>& stream)
+    {
+        int32_t ret = 0;
+        stream->read(&ret, sizeof(int32_t));
+        return SDL_SwapBE32(ret);
+    }
+
+    // Stored in native byte order. A file from a machine with another byte order fails the version check and is rebuild.
+    struct BinaryHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint64_t source_key;
+        uint32_t vertex_count;
+        uint32_t index_count;
+        float greatest_distance_from_center;
+        uint32_t reserved;
+    };
+    static_assert(sizeof(BinaryHeader) == 32, "Binary mesh header should not contain padding");
+    constexpr char binary_magic[4] = {'E', 'E', 'M', 'S'};
+}
+
+MeshData MeshData::build(std::vector<MeshVertex>&& unindexed_vertices)
+{
+    MeshData result;
+    if (unindexed_vertices.empty())
+        return result;
+
+    auto index_count = unindexed_vertices.size() / 3 * 3;
+    std::vector<uint32_t> remap(index_count); // allocate temporary memory for the remap table
+    auto vertex_count = meshopt_generateVertexRemap(remap.data(), nullptr, index_count, unindexed_vertices.data(), index_count, sizeof(MeshVertex));
+    if (vertex_count > size_t{ std::numeric_limits<uint16_t>::max() })
+    {
+        // ES 2 only supports u16 for indices - u32 is only available through an extension
+        // (a lot of systems should have it, but SP doesn't have support for it yet).
+        // Forego the indices, and inform the user.
+        result.vertices = std::move(unindexed_vertices);
+        LOG(WARNING) << "Loading mesh with a large number of vertices (" << result.vertices.size() << ").";
+    }
+    else
+    {
+        result.vertices.resize(vertex_count);
+        meshopt_remapVertexBuffer(result.vertices.data(), unindexed_vertices.data(), index_count, sizeof(MeshVertex), remap.data());
+
+        std::vector<uint32_t> indices(index_count);
+        std::vector<uint32_t> optimized_indices(index_count);
+        meshopt_remapIndexBuffer(indices.data(), nullptr, index_count, remap.data());
+        meshopt_optimizeVertexCache(optimized_indices.data(), indices.data(), index_count, vertex_count);
+        result.indices.assign(optimized_indices.begin(), optimized_indices.end());
+    }
+    result.greatest_distance_from_center = greatestDistanceFromCenter(result.vertices);
+    return result;
+}
+
+std::vector<MeshVertex> MeshData::parseSource(P<ResourceStream> stream, const string& filename)
+{
+    std::vector<MeshVertex> mesh_vertices;
+    if (filename.endswith(".obj"))
+    {
+        bool parsing_ok = true;
+        std::vector<glm::vec3> vertices;
+        std::vector<glm::vec3> normals;
+        std::vector<glm::vec2> texCoords;
+        std::vector<IndexInfo> indices;
+
+        do
+        {
+            string line = stream->readLine();
+            if (line.length() > 0 && line[0] != '#')
+            {
+                std::vector<string> parts = line.strip().split();
+                if (parts.size() < 1)
+                    continue;
+                if (parts[0] == "v")
+                {
+                    if (parts.size() >= 4)
+                    {
+                        vertices.emplace_back(parts[1].toFloat(), parts[2].toFloat(), parts[3].toFloat());
+                    }
+                    else
+                    {
+                        LOG(ERROR, "Bad vertex line: ", line);
+                        parsing_ok = false;
+                    }
+
+                }else if (parts[0] == "vn")
+                {
+                    if (parts.size() >= 4)
+                    {
+                        normals.push_back(glm::normalize(glm::vec3(parts[1].toFloat(), parts[2].toFloat(), parts[3].toFloat())));
+                    }
+                    else
+                    {
+                        LOG(ERROR, "Bad normal line: ", line);
+                        parsing_ok = false;
+                    }
+
+                }else if (parts[0] == "vt")
+                {
+                    if (parts.size() >= 3)
+                    {
+                        texCoords.push_back(glm::vec2(parts[1].toFloat(), parts[2].toFloat()));
+                    }
+                    else
+                    {
+                        LOG(ERROR, "Bad vertex texcoord line: ", line);
+                        parsing_ok = false;
+                    }
+
+                }else if (parts[0] == "f")
+                {
+                    if (parts.size() >= 4)
+                    {
+                        for (unsigned int n = 3; parsing_ok && n < parts.size(); n++)
+                        {
+                            std::vector<string> p0 = parts[1].split("/");
+                            std::vector<string> p1 = parts[n].split("/");
+                            std::vector<string> p2 = parts[n - 1].split("/");
+
+                            if (p0.size() == 3 && p1.size() == 3 && p2.size() == 3)
+                            {
+                                IndexInfo info;
+                                info.v = p0[0].toInt() - 1;
+                                info.t = p0[1].toInt() - 1;
+                                info.n = p0[2].toInt() - 1;
+                                indices.push_back(info);
+                                info.v = p2[0].toInt() - 1;
+                                info.t = p2[1].toInt() - 1;
+                                info.n = p2[2].toInt() - 1;
+                                indices.push_back(info);
+                                info.v = p1[0].toInt() - 1;
+                                info.t = p1[1].toInt() - 1;
+                                info.n = p1[2].toInt() - 1;
+                                indices.push_back(info);
+                            }
+                            else
+                            {
+                                LOG(ERROR, "Bad face triangle: ", line);
+                                parsing_ok = false;
+                            }
+                        }
+                    }
+                    else
+                    {
+                        LOG(ERROR, "Bad face line: ", line);
+                        parsing_ok = false;
+                    }
+                }else{
+                    LOG(DEBUG, "mesh: ignored: ", line);
+                }
+            }
+        }while(parsing_ok && stream->tell() < stream->getSize());
+
+        if (parsing_ok)
+        {
+            mesh_vertices.resize(indices.size());
+            for (unsigned int n = 0; n < indices.size(); n++)
+            {
+                mesh_vertices[n].position[0] = vertices[indices[n].v].x;
+                mesh_vertices[n].position[1] = vertices[indices[n].v].z;
+                mesh_vertices[n].position[2] = vertices[indices[n].v].y;
+                mesh_vertices[n].normal[0] = normals[indices[n].n].x;
+                mesh_vertices[n].normal[1] = normals[indices[n].n].z;
+                mesh_vertices[n].normal[2] = normals[indices[n].n].y;
+                mesh_vertices[n].uv[0] = texCoords[indices[n].t].x;
+                mesh_vertices[n].uv[1] = 1.f - texCoords[indices[n].t].y;
+            }
+        }
+        else
+        {
+            LOG(ERROR, "Failed to parse ", filename);
+        }
+
+
+    }else if (filename.endswith(".model"))
+    {
+        std::vector<ModelDataVertex> model_data_vertices;
+        model_data_vertices.resize(readInt(stream));
+        stream->read(model_data_vertices.data(), sizeof(ModelDataVertex) * model_data_vertices.size());
+        mesh_vertices.resize(model_data_vertices.size());
+        for(auto idx=0U; idx<model_data_vertices.size(); idx++) {
+            mesh_vertices[idx].position[0] = model_data_vertices[idx].position[0];
+            mesh_vertices[idx].position[1] = model_data_vertices[idx].position[1];
+            mesh_vertices[idx].position[2] = model_data_vertices[idx].position[2];
+            mesh_vertices[idx].normal[0] = model_data_vertices[idx].normal[0];
+            mesh_vertices[idx].normal[1] = model_data_vertices[idx].normal[1];
+            mesh_vertices[idx].normal[2] = model_data_vertices[idx].normal[2];
+            mesh_vertices[idx].uv[0] = model_data_vertices[idx].uv[0];
+            mesh_vertices[idx].uv[1] = model_data_vertices[idx].uv[1];
+        }
+    }else{
+        LOG(ERROR) << "Unknown mesh format: " << filename;
+    }
+
+    if (!mesh_vertices.empty())
+    {
+        // Calculate tangent
+        for(auto idx=0U; idx<mesh_vertices.size(); idx+=3) {
+            auto p0 = glm::vec3(mesh_vertices[idx+0].position[0], mesh_vertices[idx+0].position[1], mesh_vertices[idx+0].position[2]);
+            auto p1 = glm::vec3(mesh_vertices[idx+1].position[0], mesh_vertices[idx+1].position[1], mesh_vertices[idx+1].position[2]);
+            auto p2 = glm::vec3(mesh_vertices[idx+2].position[0], mesh_vertices[idx+2].position[1], mesh_vertices[idx+2].position[2]);
+            auto uv0 = glm::vec2(mesh_vertices[idx+0].uv[0], mesh_vertices[idx+0].uv[1]);
+            auto uv1 = glm::vec2(mesh_vertices[idx+1].uv[0], mesh_vertices[idx+1].uv[1]);
+            auto uv2 = glm::vec2(mesh_vertices[idx+2].uv[0], mesh_vertices[idx+2].uv[1]);
+
+            glm::vec3 edge1 = p1 - p0;
+            glm::vec3 edge2 = p2 - p0;
+            glm::vec2 deltaUV1 = uv1 - uv0;
+            glm::vec2 deltaUV2 = uv2 - uv0;
+
+            float f = 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y);
+
+            auto tangent = glm::vec3(
+                    f * (deltaUV2.y * edge1.x - deltaUV1.y * edge2.x),
+                    f * (deltaUV2.y * edge1.y - deltaUV1.y * edge2.y),
+                    f * (deltaUV2.y * edge1.z - deltaUV1.y * edge2.z));
+
+            for(int n=0; n<3; n++) {
+                mesh_vertices[idx+n].tangent[0] = tangent.x;
+                mesh_vertices[idx+n].tangent[1] = tangent.y;
+                mesh_vertices[idx+n].tangent[2] = tangent.z;
+            }
+        }
+    }
+    return mesh_vertices;
+}
+
+uint64_t MeshData::sourceKey(P<ResourceStream> stream)
+{
+    // FNV-1a over the whole file, hashing is a lot cheaper then parsing.
+    uint64_t key = 14695981039346656037ULL;
+    uint8_t buffer[16 * 1024];
+    stream->seek(0);
+    while(true)
+    {
+        auto size = stream->read(buffer, sizeof(buffer));
+        if (size == 0)
+            break;
+        for(size_t n=0; n<size; n++)
+            key = (key ^ buffer[n]) * 1099511628211ULL;
+    }
+    stream->seek(0);
+    return key ^ uint64_t(stream->getSize());
+}
+
+bool MeshData::readBinary(const uint8_t* data, size_t size, uint64_t source_key)
+{
+    BinaryHeader header;
+    if (size < sizeof(header))
+        return false;
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, binary_magic, sizeof(binary_magic)) != 0 || header.version != format_version || header.source_key != source_key)
+        return false;
+    size_t vertex_bytes = size_t(header.vertex_count) * sizeof(MeshVertex);
+    size_t index_bytes = size_t(header.index_count) * sizeof(uint16_t);
+    if (size < sizeof(header) + vertex_bytes + index_bytes)
+        return false;
+
+    vertices.resize(header.vertex_count);
+    memcpy(vertices.data(), data + sizeof(header), vertex_bytes);
+    indices.resize(header.index_count);
+    memcpy(indices.data(), data + sizeof(header) + vertex_bytes, index_bytes);
+    greatest_distance_from_center = header.greatest_distance_from_center;
+    return true;
+}
+
+std::vector<uint8_t> MeshData::writeBinary(uint64_t source_key) const
+{
+    BinaryHeader header{};
+    memcpy(header.magic, binary_magic, sizeof(binary_magic));
+    header.version = format_version;
+    header.source_key = source_key;
+    header.vertex_count = vertices.size();
+    header.index_count = indices.size();
+    header.greatest_distance_from_center = greatest_distance_from_center;
+
+    size_t vertex_bytes = vertices.size() * sizeof(MeshVertex);
+    size_t index_bytes = indices.size() * sizeof(uint16_t);
+    std::vector<uint8_t> result(sizeof(header) + vertex_bytes + index_bytes);
+    memcpy(result.data(), &header, sizeof(header));
+    memcpy(result.data() + sizeof(header), vertices.data(), vertex_bytes);
+    memcpy(result.data() + sizeof(header) + vertex_bytes, indices.data(), index_bytes);
+    return result;
+}
+
+float MeshData::greatestDistanceFromCenter(const std::vector<MeshVertex>& vertices)
+{
+    if (vertices.empty()) {
+        return 0;
+    }
+
+    glm::vec3 sum{};
+    for(const auto& vertex : vertices) sum += glm::vec3{vertex.position[0], vertex.position[1], vertex.position[2]};
+    auto average = sum / float(vertices.size());
+
+    auto greatest_distance = 0.f;
+    for(const auto& vertex : vertices)
+    {
+        float distance = glm::distance(average, glm::vec3{vertex.position[0], vertex.position[1], vertex.position[2]});
+        if(distance > greatest_distance) {
+            greatest_distance = distance;
+        }
+    }
+    return greatest_distance;
+}
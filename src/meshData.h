@@ -0,0 +1,48 @@
+#ifndef MESH_DATA_H
+#define MESH_DATA_H
+
+#include "resources.h"
+#include "stringImproved.h"
+#include <cstdint>
+#include <vector>
+
+struct MeshVertex
+{
+    float position[3];
+    float normal[3];
+    float uv[2];
+    float tangent[3];
+};
+
+// Mesh in the form the renderer uses: indexed, with tangents and bounds.
+// Preprocessing .obj and .model files is slow, so the result is stored in a binary .mesh file
+// that can be loaded without any processing.
+class MeshData
+{
+public:
+    static constexpr uint32_t format_version = 1;
+
+    std::vector<MeshVertex> vertices;
+    // Empty when the mesh has too many vertices for 16 bit indices, vertices are then drawn as a plain triangle list.
+    std::vector<uint16_t> indices;
+    float greatest_distance_from_center = 0.0f;
+
+    // Index the vertices, optimize the index order for the vertex cache, and calculate the bounds.
+    static MeshData build(std::vector<MeshVertex>&& unindexed_vertices);
+
+    // Parse an .obj or .model file into a triangle list with tangents.
+    static std::vector<MeshVertex> parseSource(P<ResourceStream> stream, const string& filename);
+
+    // Key that identifies the source file contents, stored in the binary file to detect outdated files.
+    static uint64_t sourceKey(P<ResourceStream> stream);
+
+    // Binary format, only valid if the source key matches.
+    bool readBinary(const uint8_t* data, size_t size, uint64_t source_key);
+    std::vector<uint8_t> writeBinary(uint64_t source_key) const;
+
+    // Calculate the center all vertices in this mesh, and return the distance
+    // of the point farthest from that center.
+    static float greatestDistanceFromCenter(const std::vector<MeshVertex>& vertices);
+};
+
+#endif//MESH_DATA_H
@@ -3,6 +3,11 @@
 #include "ecs/multiplayer.h"
 #include "ecs/query.h"
 #include "engine.h"
+#include "multiplayer/interest.h"
+#include "profiler.h"
+#include <cmath>
+#include <cstring>
+#include <type_traits>
 
 
 namespace sp::io {
@@ -10,14 +15,95 @@ namespace sp::io {
     template<typename T> static inline DataBuffer& operator >> (DataBuffer& packet, std::vector<T>& v) { uint32_t size = 0; packet >> size; v.resize(size); for(size_t n=0; n<v.size(); n++) packet >> v[n]; return packet; }
 }
 
+// Unsigned integer that is send as a variable length value, 7 bits per byte.
+// Used for the flags and indices in the replication data, which are almost always small.
+struct ReplicationVarInt {
+    uint64_t value;
+
+    static uint64_t read(sp::io::DataBuffer& packet) {
+        uint64_t result = 0;
+        for(int shift=0; shift<64; shift+=7) {
+            uint8_t byte = 0;
+            packet >> byte;
+            result |= uint64_t(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                break;
+        }
+        return result;
+    }
+};
+
+// Fixed point encoding of a float between min and max, with the amount of bits rounded up to whole bytes.
+// Values outside of the range are clamped. Ranges that contain zero decode zero exactly.
+template<int BITS> struct ReplicationQuantizer {
+    static_assert(BITS > 0 && BITS <= 32);
+    using type = std::conditional_t<(BITS <= 8), uint8_t, std::conditional_t<(BITS <= 16), uint16_t, uint32_t>>;
+    static constexpr double steps = double((uint64_t(1) << BITS) - 1);
+
+    static type encode(float value, float min, float max) {
+        double f = (double(value) - min) / (double(max) - min);
+        if (!(f > 0.0)) return 0;
+        if (f > 1.0) f = 1.0;
+        return type(std::round(f * steps));
+    }
+    static float decode(type value, float min, float max) {
+        if (min < 0.0f && max > 0.0f && value == encode(0.0f, min, max))
+            return 0.0f;
+        return float(min + (double(max) - min) * value / steps);
+    }
+};
+
+// Angles in degrees, wrapped to 0-360 before quantizing, so turrets that keep rotating do not get clamped.
+template<int BITS> struct ReplicationAngleQuantizer {
+    static_assert(BITS > 0 && BITS <= 32);
+    using type = typename ReplicationQuantizer<BITS>::type;
+    static constexpr double steps = double(uint64_t(1) << BITS);
+
+    static type encode(float value, float, float) {
+        double f = std::fmod(double(value), 360.0) / 360.0;
+        if (f < 0.0) f += 1.0;
+        return type(uint64_t(std::round(f * steps)) & ((uint64_t(1) << BITS) - 1));
+    }
+    static float decode(type value, float, float) {
+        return float(value * 360.0 / steps);
+    }
+};
+
+namespace sp::io {
+    static inline DataBuffer& operator << (DataBuffer& packet, const ReplicationVarInt& v) {
+        uint64_t value = v.value;
+        while(value >= 0x80) {
+            packet << uint8_t((value & 0x7f) | 0x80);
+            value >>= 7;
+        }
+        return packet << uint8_t(value);
+    }
+}
+
+// Raw copy of a component as it was after its last update check. When the bytes did not change since then,
+// the per field comparison would not find anything either, so it is skipped. Only possible for trivially copyable
+// components, the others (anything with a vector or string) always do the per field comparison.
+template<typename T, bool = std::is_trivially_copyable_v<T>> struct ReplicationDirtyCheck {
+    bool unchanged(const T&) const { return false; }
+    void reset(const T&) {}
+};
+template<typename T> struct ReplicationDirtyCheck<T, true> {
+    bool valid = false;
+    unsigned char last[sizeof(T)];
+
+    bool unchanged(const T& t) const { return valid && std::memcmp(last, &t, sizeof(T)) == 0; }
+    void reset(const T& t) { std::memcpy(last, &t, sizeof(T)); valid = true; }
+};
+
 enum class BasicReplicationRequest {
     SendAll, Update, Receive
 };
 #define BASIC_REPLICATION_CLASS_RATE(CLASS, COMPONENT, RATE) \
     class CLASS : public sp::ecs::ComponentReplicationBase { \
         static constexpr float update_delay = 1.0f / (RATE); \
-        struct Info { uint32_t version; float last_update = 0.0f; COMPONENT data; }; \
+        struct Info { uint32_t version; float last_update = 0.0f; COMPONENT data; ReplicationDirtyCheck<COMPONENT> dirty{}; }; \
         sp::SparseSet<Info> info; \
+        sp::io::DataBuffer scratch, vector_scratch; /* Reused for every update, so steady state replication does not allocate. */ \
         void onEntityDestroyed(uint32_t index) override; \
         void sendAll(sp::io::DataBuffer& packet) override; \
         void update(sp::io::DataBuffer& packet) override; \
@@ -37,7 +123,11 @@ enum class BasicReplicationRequest {
         } \
     } \
     void CLASS::update(sp::io::DataBuffer& packet) { \
+        static auto profiler_section = Profiler::getSection("replication", #CLASS); \
+        Profiler::Scope profiler_scope(profiler_section); \
+        if (!ReplicationInterest::hasClients()) return; \
         auto now = engine->getElapsedTime(); \
+        auto start_size = packet.getDataSize(); \
         for(auto [entity, data] : sp::ecs::Query<COMPONENT>()) { \
             if (!info.has(entity.getIndex())) { \
                 info.set(entity.getIndex(), {entity.getVersion(), now, data}); \
@@ -47,8 +137,9 @@ enum class BasicReplicationRequest {
                 if (entity_info.version != entity.getVersion()) { \
                     info.set(entity.getIndex(), {entity.getVersion(), now, data}); \
                     impl<BasicReplicationRequest::SendAll>(entity, packet, data, nullptr); \
-                } else if (entity_info.last_update + update_delay <= now) { \
+                } else if (entity_info.last_update + update_delay * ReplicationInterest::getUpdateDelayFactor(entity) <= now && !entity_info.dirty.unchanged(data)) { \
                     if (impl<BasicReplicationRequest::Update>(entity, packet, data, &entity_info.data)) entity_info.last_update = now; \
+                    entity_info.dirty.reset(data); \
                 } \
             } \
         } \
@@ -58,16 +149,20 @@ enum class BasicReplicationRequest {
                 packet << CMD_ECS_DEL_COMPONENT << component_index << index; \
             } \
         } \
+        ReplicationInterest::addReplicatedBytes(packet.getDataSize() - start_size); \
     } \
     void CLASS::receive(sp::ecs::Entity entity, sp::io::DataBuffer& packet) { impl<BasicReplicationRequest::Receive>(entity, packet, entity.getOrAddComponent<COMPONENT>(), nullptr); } \
     void CLASS::remove(sp::ecs::Entity entity) { entity.removeComponent<COMPONENT>(); } \
     template<BasicReplicationRequest BRR> bool CLASS::impl(sp::ecs::Entity entity, sp::io::DataBuffer& packet, COMPONENT& target, COMPONENT* backup) { \
-        sp::io::DataBuffer tmp; \
+        scratch.clear(); \
         uint64_t flags = 0; \
-        if (BRR == BasicReplicationRequest::Receive) packet >> flags; \
-        field_impl<BRR>(entity, packet, target, backup, tmp, flags); \
-        if (tmp.getDataSize() > 0) packet.write(CMD_ECS_SET_COMPONENT, component_index, entity.getIndex(), flags, tmp); \
-        return tmp.getDataSize() > 0; \
+        if (BRR == BasicReplicationRequest::Receive) flags = ReplicationVarInt::read(packet); \
+        field_impl<BRR>(entity, packet, target, backup, scratch, flags); \
+        if (scratch.getDataSize() > 0) { \
+            packet << CMD_ECS_SET_COMPONENT << component_index << entity.getIndex() << ReplicationVarInt{flags}; \
+            packet.write(scratch); \
+        } \
+        return scratch.getDataSize() > 0; \
     } \
     template<BasicReplicationRequest BRR> void CLASS::field_impl(sp::ecs::Entity entity, sp::io::DataBuffer& packet, COMPONENT& target, COMPONENT* backup, sp::io::DataBuffer& tmp, uint64_t& flags) { \
         uint64_t flag = 1;
@@ -79,24 +174,53 @@ enum class BasicReplicationRequest {
     case BasicReplicationRequest::Receive: if (flags & flag) packet >> target.FIELD; break; \
     } \
     flag <<= 1;
+// Opt-in lossy version of BASIC_REPLICATION_FIELD for floats with a known range.
+// Changes smaller then the resolution are not send at all.
+#define BASIC_REPLICATION_FIELD_QUANTIZED_IMPL(QUANTIZER, FIELD, MIN, MAX) \
+    switch(BRR) { \
+    case BasicReplicationRequest::SendAll: flags |= flag; tmp << QUANTIZER::encode(target.FIELD, MIN, MAX); break; \
+    case BasicReplicationRequest::Update: { auto q = QUANTIZER::encode(target.FIELD, MIN, MAX); if (q != QUANTIZER::encode(backup->FIELD, MIN, MAX)) { flags |= flag; tmp << q; backup->FIELD = target.FIELD; } } break; \
+    case BasicReplicationRequest::Receive: if (flags & flag) { QUANTIZER::type q = 0; packet >> q; target.FIELD = QUANTIZER::decode(q, MIN, MAX); } break; \
+    } \
+    flag <<= 1;
+#define BASIC_REPLICATION_FIELD_QUANTIZED(FIELD, MIN, MAX, BITS) BASIC_REPLICATION_FIELD_QUANTIZED_IMPL(ReplicationQuantizer<BITS>, FIELD, MIN, MAX)
+#define BASIC_REPLICATION_FIELD_ANGLE(FIELD, BITS) BASIC_REPLICATION_FIELD_QUANTIZED_IMPL(ReplicationAngleQuantizer<BITS>, FIELD, 0.0f, 360.0f)
+// Fields shared by all ShipSystem based components, with PREFIX to reach the ShipSystem inside the component.
+#define BASIC_REPLICATION_SHIP_SYSTEM(PREFIX) \
+    BASIC_REPLICATION_FIELD_QUANTIZED(PREFIX health, -1.0f, 1.0f, 16); \
+    BASIC_REPLICATION_FIELD_QUANTIZED(PREFIX health_max, -1.0f, 1.0f, 16); \
+    BASIC_REPLICATION_FIELD_QUANTIZED(PREFIX power_level, 0.0f, 3.0f, 16); \
+    BASIC_REPLICATION_FIELD_QUANTIZED(PREFIX power_request, 0.0f, 3.0f, 16); \
+    BASIC_REPLICATION_FIELD_QUANTIZED(PREFIX heat_level, 0.0f, 1.0f, 16); \
+    BASIC_REPLICATION_FIELD_QUANTIZED(PREFIX coolant_level, 0.0f, 100.0f, 16); \
+    BASIC_REPLICATION_FIELD_QUANTIZED(PREFIX coolant_request, 0.0f, 100.0f, 16); \
+    BASIC_REPLICATION_FIELD(PREFIX can_be_hacked); \
+    BASIC_REPLICATION_FIELD_QUANTIZED(PREFIX hacked_level, 0.0f, 1.0f, 16); \
+    BASIC_REPLICATION_FIELD(PREFIX power_factor); \
+    BASIC_REPLICATION_FIELD(PREFIX coolant_change_rate_per_second); \
+    BASIC_REPLICATION_FIELD(PREFIX heat_add_rate_per_second); \
+    BASIC_REPLICATION_FIELD(PREFIX power_change_rate_per_second); \
+    BASIC_REPLICATION_FIELD(PREFIX auto_repair_per_second); \
+    BASIC_REPLICATION_FIELD(PREFIX damage_per_second_on_overheat);
 #define BASIC_REPLICATION_VECTOR(FIELD) \
     switch(BRR) { \
-    case BasicReplicationRequest::SendAll: flags |= flag; tmp << target.FIELD.size(); break; \
-    case BasicReplicationRequest::Update: if (target.FIELD.size() != backup->FIELD.size()) { flags |= flag; tmp << target.FIELD.size(); backup->FIELD.resize(target.FIELD.size()); } break; \
-    case BasicReplicationRequest::Receive: if (flags & flag) { size_t size; packet >> size; target.FIELD.resize(size); } break; \
+    case BasicReplicationRequest::SendAll: flags |= flag; tmp << ReplicationVarInt{target.FIELD.size()}; break; \
+    case BasicReplicationRequest::Update: if (target.FIELD.size() != backup->FIELD.size()) { flags |= flag; tmp << ReplicationVarInt{target.FIELD.size()}; backup->FIELD.resize(target.FIELD.size()); } break; \
+    case BasicReplicationRequest::Receive: if (flags & flag) { target.FIELD.resize(ReplicationVarInt::read(packet)); } break; \
     } \
     flag <<= 1; \
     for(size_t idx=0; (BRR==BasicReplicationRequest::Receive) || idx<target.FIELD.size(); idx++) { \
         uint32_t vector_flags = 0; \
         if (BRR == BasicReplicationRequest::Receive) { \
-            packet >> vector_flags; \
+            vector_flags = uint32_t(ReplicationVarInt::read(packet)); \
             if (vector_flags == 0) break; \
-            packet >> idx; \
+            idx = ReplicationVarInt::read(packet); \
             if (idx >= target.FIELD.size()) { LOG(Warning, "Vector replication index out of range..."); break; } \
         } \
         auto vector_target = &target.FIELD[idx]; \
         auto vector_backup = backup ? &backup->FIELD[idx] : nullptr; \
-        sp::io::DataBuffer vector_tmp; \
+        auto& vector_tmp = vector_scratch; \
+        vector_tmp.clear(); \
         uint32_t vector_flag = 1;
 
 #define VECTOR_REPLICATION_FIELD(FIELD) \
@@ -106,11 +230,20 @@ enum class BasicReplicationRequest {
         case BasicReplicationRequest::Receive: if (vector_flags & vector_flag) packet >> vector_target->FIELD; break; \
         } \
         vector_flag <<= 1;
+#define VECTOR_REPLICATION_FIELD_QUANTIZED_IMPL(QUANTIZER, FIELD, MIN, MAX) \
+        switch(BRR) { \
+        case BasicReplicationRequest::SendAll: vector_flags |= vector_flag; vector_tmp << QUANTIZER::encode(vector_target->FIELD, MIN, MAX); break; \
+        case BasicReplicationRequest::Update: { auto q = QUANTIZER::encode(vector_target->FIELD, MIN, MAX); if (q != QUANTIZER::encode(vector_backup->FIELD, MIN, MAX)) { vector_flags |= vector_flag; vector_tmp << q; vector_backup->FIELD = vector_target->FIELD; } } break; \
+        case BasicReplicationRequest::Receive: if (vector_flags & vector_flag) { QUANTIZER::type q = 0; packet >> q; vector_target->FIELD = QUANTIZER::decode(q, MIN, MAX); } break; \
+        } \
+        vector_flag <<= 1;
+#define VECTOR_REPLICATION_FIELD_QUANTIZED(FIELD, MIN, MAX, BITS) VECTOR_REPLICATION_FIELD_QUANTIZED_IMPL(ReplicationQuantizer<BITS>, FIELD, MIN, MAX)
+#define VECTOR_REPLICATION_FIELD_ANGLE(FIELD, BITS) VECTOR_REPLICATION_FIELD_QUANTIZED_IMPL(ReplicationAngleQuantizer<BITS>, FIELD, 0.0f, 360.0f)
 
 #define VECTOR_REPLICATION_END() \
-        if (vector_tmp.getDataSize() > 0) tmp.write(vector_flags, idx, vector_tmp); \
+        if (vector_tmp.getDataSize() > 0) { tmp << ReplicationVarInt{vector_flags} << ReplicationVarInt{idx}; tmp.write(vector_tmp); } \
     } \
-    if (tmp.getDataSize() > 0) tmp.write(uint32_t(0)); // end of vector update.
+    if (tmp.getDataSize() > 0) tmp << ReplicationVarInt{0}; // end of vector update.
 
 
 
@@ -2,21 +2,7 @@
 #include "multiplayer.h"
 
 BASIC_REPLICATION_IMPL(BeamWeaponSysReplication, BeamWeaponSys)
-    BASIC_REPLICATION_FIELD(health);
-    BASIC_REPLICATION_FIELD(health_max);
-    BASIC_REPLICATION_FIELD(power_level);
-    BASIC_REPLICATION_FIELD(power_request);
-    BASIC_REPLICATION_FIELD(heat_level);
-    BASIC_REPLICATION_FIELD(coolant_level);
-    BASIC_REPLICATION_FIELD(coolant_request);
-    BASIC_REPLICATION_FIELD(can_be_hacked);
-    BASIC_REPLICATION_FIELD(hacked_level);
-    BASIC_REPLICATION_FIELD(power_factor);
-    BASIC_REPLICATION_FIELD(coolant_change_rate_per_second);
-    BASIC_REPLICATION_FIELD(heat_add_rate_per_second);
-    BASIC_REPLICATION_FIELD(power_change_rate_per_second);
-    BASIC_REPLICATION_FIELD(auto_repair_per_second);
-    BASIC_REPLICATION_FIELD(damage_per_second_on_overheat);
+    BASIC_REPLICATION_SHIP_SYSTEM();
 
     BASIC_REPLICATION_FIELD(frequency);
     BASIC_REPLICATION_FIELD(system_target);
@@ -24,10 +10,10 @@ BASIC_REPLICATION_IMPL(BeamWeaponSysReplication, BeamWeaponSys)
     BASIC_REPLICATION_VECTOR(mounts)
         VECTOR_REPLICATION_FIELD(position);
         VECTOR_REPLICATION_FIELD(arc);
-        VECTOR_REPLICATION_FIELD(direction);
+        VECTOR_REPLICATION_FIELD_ANGLE(direction, 16);
         VECTOR_REPLICATION_FIELD(range);
         VECTOR_REPLICATION_FIELD(turret_arc);
-        VECTOR_REPLICATION_FIELD(turret_direction);
+        VECTOR_REPLICATION_FIELD_ANGLE(turret_direction, 16);
         VECTOR_REPLICATION_FIELD(turret_rotation_rate);
         VECTOR_REPLICATION_FIELD(cycle_time);
         VECTOR_REPLICATION_FIELD(damage);
@@ -0,0 +1,160 @@
+#include "multiplayer/interest.h"
+#include "components/collision.h"
+#include "components/radar.h"
+#include "components/target.h"
+#include "components/scanning.h"
+#include "components/faction.h"
+#include "playerInfo.h"
+#include "ecs/query.h"
+#include "engine.h"
+#include <glm/gtx/norm.hpp>
+#include <limits>
+#include <algorithm>
+
+
+bool ReplicationInterest::force_clients = false;
+float ReplicationInterest::last_refresh = -1.0f;
+std::vector<ReplicationInterest::Level> ReplicationInterest::levels;
+ReplicationInterest::Stats ReplicationInterest::stats;
+float ReplicationInterest::stats_start = 0.0f;
+size_t ReplicationInterest::stats_bytes = 0;
+uint64_t ReplicationInterest::total_bytes = 0;
+
+
+ReplicationInterest::Level ReplicationInterest::get(sp::ecs::Entity entity)
+{
+    if (last_refresh != engine->getElapsedTime())
+        refresh();
+    if (entity.getIndex() < levels.size())
+        return levels[entity.getIndex()];
+    return Level::Full;
+}
+
+float ReplicationInterest::getUpdateDelayFactor(sp::ecs::Entity entity)
+{
+    switch(get(entity))
+    {
+    case Level::Full: return 1.0f;
+    case Level::Reduced: return reduced_rate_factor;
+    case Level::None: return std::numeric_limits<float>::infinity();
+    }
+    return 1.0f;
+}
+
+bool ReplicationInterest::hasClients()
+{
+    if (force_clients)
+        return true;
+    // Not cached per tick, clients can connect while the game is paused.
+    foreach(PlayerInfo, i, player_info_list)
+        if (i->client_id != 0)
+            return true;
+    return false;
+}
+
+void ReplicationInterest::addReplicatedBytes(size_t bytes)
+{
+    stats_bytes += bytes;
+    total_bytes += bytes;
+}
+
+void ReplicationInterest::refresh()
+{
+    auto now = engine->getElapsedTime();
+    last_refresh = now;
+    if (now - stats_start >= 1.0f || now < stats_start) {
+        stats.bytes_per_second = now > stats_start ? stats_bytes / (now - stats_start) : 0.0f;
+        stats_bytes = 0;
+        stats_start = now;
+    }
+
+    struct Viewpoint {
+        sp::ecs::Entity ship;
+        glm::vec2 position;
+        float full_range;
+        float scanned_range;
+        float reduced_range;
+    };
+    static std::vector<Viewpoint> viewpoints;
+    static std::vector<sp::ecs::Entity> targets;
+    viewpoints.clear();
+    targets.clear();
+    bool full_visibility = false;
+    foreach(PlayerInfo, i, player_info_list)
+    {
+        // The server's own player info does not receive any replication.
+        if (i->client_id == 0)
+            continue;
+        auto transform = i->ship.getComponent<sp::Transform>();
+        if (!transform) {
+            full_visibility = true;
+            break;
+        }
+        auto lrr = i->ship.getComponent<LongRangeRadar>();
+        float short_range = lrr ? lrr->short_range : 5000.0f;
+        float long_range = lrr ? lrr->long_range : 30000.0f;
+        viewpoints.push_back({i->ship, transform->getPosition(), short_range, long_range, long_range * 1.5f});
+        if (auto target = i->ship.getComponent<Target>())
+            targets.push_back(target->entity);
+    }
+
+    std::fill(levels.begin(), levels.end(), Level::Full);
+    stats.full = stats.reduced = stats.none = 0;
+    // Without clients nothing is replicated at all, see hasClients().
+    if (viewpoints.empty() && !full_visibility)
+        return;
+    if (full_visibility) {
+        for(auto [entity, transform] : sp::ecs::Query<sp::Transform>())
+            stats.full++;
+        return;
+    }
+
+    // Friendly ships, stations and probes share their short range radar with the relay officer.
+    auto ship_count = viewpoints.size();
+    for(auto [entity, share, transform] : sp::ecs::Query<ShareShortRangeRadar, sp::Transform>())
+    {
+        for(size_t n=0; n<ship_count; n++)
+        {
+            if (viewpoints[n].ship == entity || Faction::getRelation(viewpoints[n].ship, entity) != FactionRelation::Friendly)
+                continue;
+            auto lrr = entity.getComponent<LongRangeRadar>();
+            float short_range = lrr ? lrr->short_range : 5000.0f;
+            viewpoints.push_back({viewpoints[n].ship, transform.getPosition(), short_range, short_range, short_range * 1.5f});
+            break;
+        }
+    }
+
+    for(auto [entity, transform] : sp::ecs::Query<sp::Transform>())
+    {
+        auto level = Level::None;
+        auto position = transform.getPosition();
+        for(auto& vp : viewpoints)
+        {
+            auto dist2 = glm::length2(position - vp.position);
+            if (dist2 < vp.full_range * vp.full_range) {
+                level = Level::Full;
+                break;
+            }
+            if (dist2 < vp.scanned_range * vp.scanned_range) {
+                auto scan_state = entity.getComponent<ScanState>();
+                if (!scan_state || scan_state->getStateFor(vp.ship) != ScanState::State::NotScanned) {
+                    level = Level::Full;
+                    break;
+                }
+            }
+            if (dist2 < vp.reduced_range * vp.reduced_range)
+                level = Level::Reduced;
+        }
+        if (level != Level::Full && std::find(targets.begin(), targets.end(), entity) != targets.end())
+            level = Level::Full;
+        if (entity.getIndex() >= levels.size())
+            levels.resize(entity.getIndex() + 1, Level::Full);
+        levels[entity.getIndex()] = level;
+        switch(level)
+        {
+        case Level::Full: stats.full++; break;
+        case Level::Reduced: stats.reduced++; break;
+        case Level::None: stats.none++; break;
+        }
+    }
+}
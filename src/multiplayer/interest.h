@@ -0,0 +1,53 @@
+#pragma once
+
+#include "ecs/entity.h"
+#include <vector>
+
+
+// Decides how often the components of an entity need to be replicated, depending on what the connected crews can see.
+// All clients receive the same stream, so the most interested client decides the level of an entity.
+// Clients without a ship (game master, spectator, cinematic view) can see everything, so everything stays at full rate while one is connected.
+class ReplicationInterest
+{
+public:
+    enum class Level : uint8_t {
+        Full,    // Near a crew, targeted, or not something with a position.
+        Reduced, // On long range radar, but not scanned, or just outside of radar range.
+        None,    // No crew can see this, component updates are held back until it becomes visible.
+    };
+    // Reduced interest entities are updated this many times less often.
+    static constexpr float reduced_rate_factor = 4.0f;
+
+    static Level get(sp::ecs::Entity entity);
+    // Multiplier for the update delay of a replication class, infinite for entities nobody can see.
+    static float getUpdateDelayFactor(sp::ecs::Entity entity);
+
+    // False while no client is connected. Replication classes then skip their updates entirely,
+    // a client that connects later gets the full state through sendAll first.
+    static bool hasClients();
+    // Replicate as if a client is connected, for the benchmark self check which has no clients.
+    static void forceClients(bool force) { force_clients = force; }
+
+    static void addReplicatedBytes(size_t bytes);
+
+    struct Stats {
+        int full = 0;
+        int reduced = 0;
+        int none = 0;
+        float bytes_per_second = 0.0f; // Of the component stream, which every connected client receives in full.
+    };
+    static const Stats& getStats() { return stats; }
+    // All component bytes replicated since the start.
+    static uint64_t getTotalBytes() { return total_bytes; }
+
+private:
+    static void refresh();
+
+    static bool force_clients;
+    static float last_refresh;
+    static std::vector<Level> levels; // Per entity index.
+    static Stats stats;
+    static float stats_start;
+    static size_t stats_bytes;
+    static uint64_t total_bytes;
+};
@@ -1,9 +1,17 @@
 #include "multiplayer/shiplog.h"
 #include "ecs/query.h"
 #include "components/shiplog.h"
+#include "profiler.h"
+#include <algorithm>
 
 static constexpr unsigned int FULL_UPDATE = 0;
 static constexpr unsigned int ADDITION = 1;
+static constexpr unsigned int CLEAR = 2;
+static constexpr unsigned int HISTORY = 3;
+
+// Amount of entries a client gets when it joins or requests older entries,
+// so the join time bandwidth does not depend on how long the session has been running.
+static constexpr size_t history_chunk_size = 100;
 
 
 void ShipLogReplication::onEntityDestroyed(uint32_t index)
@@ -20,20 +28,43 @@ void ShipLogReplication::sendAll(sp::io::DataBuffer& packet)
 
 void ShipLogReplication::update(sp::io::DataBuffer& packet)
 {
+    static auto profiler_section = Profiler::getSection("replication", "ShipLogReplication");
+    Profiler::Scope profiler_scope(profiler_section);
+    if (!ReplicationInterest::hasClients())
+        return;
     for(auto [entity, log] : sp::ecs::Query<ShipLog>()) {
-        if (log.cleared) {
+        if (!info.has(entity.getIndex()) || info.get(entity.getIndex()).version != entity.getVersion()) {
             addFullUpdate(packet, entity, log);
             log.cleared = false;
-        } else if (log.new_entry_count > 0) {
-            auto new_entries = std::min(log.new_entry_count, log.size());
-            packet.write(CMD_ECS_SET_COMPONENT, component_index, entity.getIndex(), ADDITION, new_entries);
-            for(size_t n=log.size() - new_entries; n<log.size(); n++) {
-                const auto& e = log.get(n);
-                packet << e.prefix << e.text << e.color;
-            }
-            log.new_entry_count = 0;
+            log.history_requests.clear();
+            info.set(entity.getIndex(), {entity.getVersion(), log.getNextSeq()});
+            continue;
+        }
+        auto& entity_info = info.get(entity.getIndex());
+        if (log.cleared) {
+            packet.write(CMD_ECS_SET_COMPONENT, component_index, entity.getIndex(), CLEAR, log.getFirstSeq());
+            log.cleared = false;
         }
-        info.set(entity.getIndex(), {entity.getVersion()});
+        if (log.getNextSeq() > entity_info.sent_seq) {
+            // Only entries that are still in the log can be send, if more where added then fit, the oldest are skipped.
+            auto first_seq = std::max(entity_info.sent_seq, log.getFirstSeq());
+            auto amount = log.getNextSeq() - first_seq;
+            packet.write(CMD_ECS_SET_COMPONENT, component_index, entity.getIndex(), ADDITION, first_seq, size_t(amount));
+            addEntries(packet, log, log.size() - amount, amount, false);
+            entity_info.sent_seq = log.getNextSeq();
+        }
+        // Clients that joined at different times ask for different entries, all of them are answered,
+        // every client only takes the entries that fit in front of what it has.
+        for(auto request : log.history_requests) {
+            // Send the entries just before the requested sequence number, newest first.
+            auto before_seq = std::min(request, log.getNextSeq());
+            size_t amount = 0;
+            if (before_seq > log.getFirstSeq())
+                amount = std::min(size_t(before_seq - log.getFirstSeq()), history_chunk_size);
+            packet.write(CMD_ECS_SET_COMPONENT, component_index, entity.getIndex(), HISTORY, log.getFirstSeq(), before_seq, amount);
+            addEntries(packet, log, before_seq - log.getFirstSeq() - 1, amount, true);
+        }
+        log.history_requests.clear();
     }
     for(auto [index, entity_info] : info) {
         if (!sp::ecs::Entity::forced(index, entity_info.version).hasComponent<ShipLog>()) {
@@ -47,15 +78,31 @@ void ShipLogReplication::receive(sp::ecs::Entity entity, sp::io::DataBuffer& pac
 {
     auto& log = entity.getOrAddComponent<ShipLog>();
     unsigned int update_type = 0;
-    size_t amount = 0;
-    packet >> update_type >> amount;
-    if (update_type == FULL_UPDATE)
-        log.clear();
-    for(size_t n=0; n<amount; n++) {
-        string prefix, message;
-        glm::u8vec4 color;
-        packet >> prefix >> message >> color;
-        log.add(prefix, message, color);
+    packet >> update_type;
+    switch(update_type)
+    {
+    case FULL_UPDATE:{
+        auto [history_first_seq, first_seq] = packet.read<uint32_t, uint32_t>();
+        log.clear(first_seq);
+        log.history_first_seq = history_first_seq;
+        readEntries(packet, log, first_seq, false);
+        }break;
+    case ADDITION:{
+        uint32_t first_seq = 0;
+        packet >> first_seq;
+        readEntries(packet, log, first_seq, false);
+        }break;
+    case CLEAR:{
+        uint32_t next_seq = 0;
+        packet >> next_seq;
+        log.clear(next_seq);
+        log.history_first_seq = next_seq;
+        }break;
+    case HISTORY:{
+        auto [history_first_seq, before_seq] = packet.read<uint32_t, uint32_t>();
+        log.history_first_seq = history_first_seq;
+        readEntries(packet, log, before_seq - 1, true);
+        }break;
     }
 }
 
@@ -66,9 +113,41 @@ void ShipLogReplication::remove(sp::ecs::Entity entity)
 
 void ShipLogReplication::addFullUpdate(sp::io::DataBuffer& packet, sp::ecs::Entity entity, const ShipLog& log)
 {
-    packet.write(CMD_ECS_SET_COMPONENT, component_index, entity.getIndex(), FULL_UPDATE, log.size());
-    for(size_t n=0; n<log.size(); n++) {
-        const auto& e = log.get(n);
-        packet << e.prefix << e.text << e.color;
+    auto amount = std::min(log.size(), history_chunk_size);
+    packet.write(CMD_ECS_SET_COMPONENT, component_index, entity.getIndex(), FULL_UPDATE, log.getFirstSeq(), log.getNextSeq() - uint32_t(amount), amount);
+    addEntries(packet, log, log.size() - amount, amount, false);
+}
+
+void ShipLogReplication::addEntries(sp::io::DataBuffer& packet, const ShipLog& log, size_t first_index, size_t amount, bool reverse)
+{
+    // Most entries share the mission time prefix with the entry before it, so it is only send when it changes.
+    const string* prefix = nullptr;
+    for(size_t n=0; n<amount; n++) {
+        const auto& e = log.get(reverse ? first_index - n : first_index + n);
+        bool same_prefix = prefix && *prefix == e.prefix;
+        packet << same_prefix;
+        if (!same_prefix)
+            packet << e.prefix;
+        packet << e.text << e.color;
+        prefix = &e.prefix;
+    }
+}
+
+void ShipLogReplication::readEntries(sp::io::DataBuffer& packet, ShipLog& log, uint32_t first_seq, bool history)
+{
+    size_t amount = 0;
+    packet >> amount;
+    string prefix, message;
+    glm::u8vec4 color;
+    for(size_t n=0; n<amount; n++) {
+        bool same_prefix = false;
+        packet >> same_prefix;
+        if (!same_prefix)
+            packet >> prefix;
+        packet >> message >> color;
+        if (history)
+            log.addReceivedHistory(first_seq - n, prefix, message, color);
+        else
+            log.addReceived(first_seq + n, prefix, message, color);
     }
-}
\ No newline at end of file
+}
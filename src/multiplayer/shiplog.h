@@ -5,7 +5,7 @@
 #include "components/shiplog.h"
 
 class ShipLogReplication : public sp::ecs::ComponentReplicationBase {
-    struct Info { uint32_t version; };
+    struct Info { uint32_t version; uint32_t sent_seq; };
     sp::SparseSet<Info> info;
 
     void onEntityDestroyed(uint32_t index) override;
@@ -15,4 +15,6 @@ class ShipLogReplication : public sp::ecs::ComponentReplicationBase {
     void remove(sp::ecs::Entity entity) override;
 
     void addFullUpdate(sp::io::DataBuffer& packet, sp::ecs::Entity entity, const ShipLog& log);
-};
\ No newline at end of file
+    void addEntries(sp::io::DataBuffer& packet, const ShipLog& log, size_t first_index, size_t amount, bool reverse);
+    void readEntries(sp::io::DataBuffer& packet, ShipLog& log, uint32_t first_seq, bool history);
+};
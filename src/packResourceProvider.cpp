@@ -1,6 +1,9 @@
 #include "packResourceProvider.h"
 
 #include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <array>
 #include <SDL_endian.h>
 #include <SDL_rwops.h>
 
@@ -37,10 +40,55 @@ static inline string readString(SDL_RWops *f)
     return string(buffer);
 }
 
+static uint32_t crc32(const uint8_t* data, size_t size)
+{
+    // Function local statics are initialized exactly once, even when the asset loader threads get here at the same time.
+    static const std::array<uint32_t, 256> table = []() {
+        std::array<uint32_t, 256> result;
+        for(uint32_t n=0; n<256; n++)
+        {
+            uint32_t c = n;
+            for(int k=0; k<8; k++)
+                c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+            result[n] = c;
+        }
+        return result;
+    }();
+    uint32_t crc = 0xFFFFFFFF;
+    for(size_t n=0; n<size; n++)
+        crc = table[(crc ^ data[n]) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFF;
+}
+
+// Glob match where '*' matches any sequence of characters, including '/'.
+static bool matchPattern(const char* name, const char* pattern)
+{
+    for(; *pattern; pattern++, name++)
+    {
+        if (*pattern == '*')
+        {
+            for(const char* rest = name; ; rest++)
+            {
+                if (matchPattern(rest, pattern + 1))
+                    return true;
+                if (!*rest)
+                    return false;
+            }
+        }
+        if (*name != *pattern)
+            return false;
+    }
+    return *name == '\0';
+}
+
 PackResourceProvider::PackResourceProvider(string filename)
 : filename(filename)
 {
-    auto f = SDL_RWFromFile(filename.c_str(), "rb");
+    mapping = std::make_unique<MappedFile>(filename);
+    if (!mapping->isOpen())
+        mapping = nullptr;
+
+    auto f = mapping ? SDL_RWFromConstMem(mapping->data(), int(mapping->size())) : SDL_RWFromFile(filename.c_str(), "rb");
     if (!f)
     {
         LOG(WARNING) << "Failed to open " << filename << ": " << SDL_GetError();
@@ -48,7 +96,7 @@ PackResourceProvider::PackResourceProvider(string filename)
     }
 
     int version = readInt(f);
-    if (version == 0)
+    if (version == 0 || version == 1)
     {
         int file_count = readInt(f);
         LOG(INFO) << "Loaded: " << filename << " with " << file_count << " files";
@@ -57,7 +105,15 @@ PackResourceProvider::PackResourceProvider(string filename)
             string fileName = readString(f);
             int position = readInt(f);
             int size = readInt(f);
-            files[fileName] = PackResourceInfo(position, size);
+            PackResourceInfo info(position, size);
+            if (version >= 1)
+                info.checksum = readInt(f);
+            if (mapping && info.position + info.size > mapping->size())
+            {
+                LOG(WARNING) << filename << ": " << fileName << " is outside of the pack, skipping it.";
+                continue;
+            }
+            files[fileName] = info;
         }
     }
     else
@@ -65,18 +121,58 @@ PackResourceProvider::PackResourceProvider(string filename)
         LOG(WARNING) << filename << " has unknown version " << version;
     }
     SDL_RWclose(f);
+
+    sorted_filenames.reserve(files.size());
+    for(auto& it : files)
+        sorted_filenames.push_back(it.first);
+    std::sort(sorted_filenames.begin(), sorted_filenames.end());
+}
+
+bool PackResourceProvider::verify(const string& name, PackResourceInfo& info)
+{
+    // Checksums are only checked the first time an entry is opened, so untouched entries are never paged in.
+    if (info.checksum == 0)
+        return true;
+    // Resources are also opened from the asset loader threads.
+    std::lock_guard<std::mutex> lock(verify_mutex);
+    if (info.verified)
+        return true;
+    if (crc32(mapping->data() + info.position, info.size) != info.checksum)
+    {
+        LOG(ERROR) << filename << ": " << name << " failed its checksum.";
+        return false;
+    }
+    info.verified = true;
+    return true;
 }
 
 P<ResourceStream> PackResourceProvider::getResourceStream(const string filename)
 {
-    if (files.find(filename) != files.end())
-        return new PackResourceStream(this->filename, files.find(filename)->second);
-    return NULL;
+    auto it = files.find(filename);
+    if (it == files.end())
+        return NULL;
+    if (!mapping)
+        return new PackResourceStream(this->filename, it->second);
+    if (!verify(filename, it->second))
+        return NULL;
+    return new PackMemoryResourceStream(mapping->data() + it->second.position, it->second.size);
 }
 
 std::vector<string> PackResourceProvider::findResources(const string searchPattern)
 {
     std::vector<string> ret;
+    // Everything before the first wildcard is a plain prefix, so only that range of the sorted names needs to be matched.
+    size_t prefix_length = 0;
+    while(prefix_length < searchPattern.length() && searchPattern[prefix_length] != '*')
+        prefix_length++;
+    string prefix(std::string(searchPattern.c_str(), prefix_length));
+    for(auto it = std::lower_bound(sorted_filenames.begin(), sorted_filenames.end(), prefix); it != sorted_filenames.end(); ++it)
+    {
+        if (strncmp(it->c_str(), prefix.c_str(), prefix_length) != 0)
+            break;
+        if (matchPattern(it->c_str(), searchPattern.c_str()))
+            ret.push_back(*it);
+    }
     return ret;
 }
 
@@ -183,3 +279,33 @@ size_t PackResourceStream::getSize()
 {
     return size;
 }
+
+PackMemoryResourceStream::PackMemoryResourceStream(const uint8_t* data, size_t size)
+: data(data), size(size)
+{
+}
+
+size_t PackMemoryResourceStream::read(void* buffer, size_t size)
+{
+    if (read_position + size > this->size)
+        size = this->size - read_position;
+    memcpy(buffer, data + read_position, size);
+    read_position += size;
+    return size;
+}
+
+size_t PackMemoryResourceStream::seek(size_t position)
+{
+    read_position = std::min(position, size);
+    return read_position;
+}
+
+size_t PackMemoryResourceStream::tell()
+{
+    return read_position;
+}
+
+size_t PackMemoryResourceStream::getSize()
+{
+    return size;
+}
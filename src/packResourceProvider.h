@@ -2,7 +2,10 @@
 #define PACK_RESOURCE_PROVIDER_H
 
 #include "resources.h"
+#include "mappedFile.h"
 #include <unordered_map>
+#include <memory>
+#include <mutex>
 
 struct PackResourceInfo
 {
@@ -11,12 +14,21 @@ struct PackResourceInfo
 
     size_t position;
     size_t size;
+    uint32_t checksum = 0; // CRC32 of the data, format version 1 and up, 0 when the pack has no checksums.
+    bool verified = false; // Only accessed with the verify_mutex of the provider held.
 };
 
 class PackResourceProvider : public ResourceProvider
 {
     string filename;
     std::unordered_map<string, PackResourceInfo> files;
+    // All filenames, sorted, for prefix search in findResources.
+    std::vector<string> sorted_filenames;
+    // The pack is mapped once, and streams are views into it. Without a mapping (Android assets) every stream opens the pack itself.
+    std::unique_ptr<MappedFile> mapping;
+    std::mutex verify_mutex;
+
+    bool verify(const string& name, PackResourceInfo& info);
 public:
     PackResourceProvider(string filename);
 
@@ -45,4 +57,20 @@ public:
     friend class PackResourceProvider;
 };
 
+class PackMemoryResourceStream : public ResourceStream
+{
+    const uint8_t* data;
+    size_t size;
+    size_t read_position = 0;
+
+    PackMemoryResourceStream(const uint8_t* data, size_t size);
+public:
+    virtual size_t read(void* data, size_t size) override;
+    virtual size_t seek(size_t position) override;
+    virtual size_t tell() override;
+    virtual size_t getSize() override;
+
+    friend class PackResourceProvider;
+};
+
 #endif//PACK_RESOURCE_PROVIDER_H
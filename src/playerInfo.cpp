@@ -59,6 +59,8 @@
 #include "systems/comms.h"
 #include "systems/scanning.h"
 
+#include <algorithm>
+
 //Ship commands
 static const uint16_t CMD_TARGET_ROTATION = 0x0001;
 static const uint16_t CMD_IMPULSE = 0x0002;
@@ -104,6 +106,7 @@ static const uint16_t CMD_CUSTOM_FUNCTION = 0x0029;
 static const uint16_t CMD_TURN_SPEED = 0x002A;
 static const uint16_t CMD_CREW_SET_TARGET = 0x002B;
 static const uint16_t CMD_ABORT_JUMP = 0x002C;
+static const uint16_t CMD_REQUEST_SHIP_LOG_HISTORY = 0x002D;
 
 //Pre-ship commands
 static const uint16_t CMD_UPDATE_CREW_POSITION = 0x0101;
@@ -606,6 +609,13 @@ void PlayerInfo::commandCrewSetTargetPosition(sp::ecs::Entity crew, glm::ivec2 p
     sendClientCommand(packet);
 }
 
+void PlayerInfo::commandRequestShipLogHistory(uint32_t before_seq)
+{
+    sp::io::DataBuffer packet;
+    packet << CMD_REQUEST_SHIP_LOG_HISTORY << before_seq;
+    sendClientCommand(packet);
+}
+
 void PlayerInfo::onReceiveClientCommand(int32_t client_id, sp::io::DataBuffer& packet)
 {
     if (client_id != this->client_id) return;
@@ -1079,6 +1089,13 @@ void PlayerInfo::onReceiveClientCommand(int32_t client_id, sp::io::DataBuffer& p
             if (auto ic = crew.getComponent<InternalCrew>())
                 ic->target_position = position;
         }break;
+    case CMD_REQUEST_SHIP_LOG_HISTORY:{
+            uint32_t before_seq = 0;
+            packet >> before_seq;
+            if (auto log = ship.getComponent<ShipLog>())
+                if (std::find(log->history_requests.begin(), log->history_requests.end(), before_seq) == log->history_requests.end())
+                    log->history_requests.push_back(before_seq);
+        }break;
     }
 }
 
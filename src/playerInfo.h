@@ -88,6 +88,7 @@ public:
     void commandSetName(const string& name);
 
     void commandCrewSetTargetPosition(sp::ecs::Entity crew, glm::ivec2 target);
+    void commandRequestShipLogHistory(uint32_t before_seq);
 
     virtual void onReceiveClientCommand(int32_t client_id, sp::io::DataBuffer& packet) override;
 
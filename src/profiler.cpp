@@ -0,0 +1,53 @@
+#include "profiler.h"
+
+#include <algorithm>
+
+
+std::vector<std::unique_ptr<Profiler::Section>> Profiler::sections;
+
+Profiler::Section* Profiler::getSection(const string& group, const string& name)
+{
+    for(auto& section : sections)
+        if (section->group == group && section->name == name)
+            return section.get();
+    sections.push_back(std::make_unique<Section>());
+    sections.back()->group = group;
+    sections.back()->name = name;
+    return sections.back().get();
+}
+
+Profiler::Percentiles Profiler::getPercentiles(const Section& section)
+{
+    Percentiles result;
+    size_t count = std::min<uint64_t>(section.count, sample_count);
+    if (count == 0)
+        return result;
+    // Until the ring has wrapped around, only the start of it holds samples.
+    std::array<float, sample_count> sorted = section.samples;
+    std::sort(sorted.begin(), sorted.begin() + count);
+    auto at = [&sorted, count](float fraction) { return sorted[std::min(count - 1, size_t(fraction * count))]; };
+    result.p50 = at(0.5f);
+    result.p90 = at(0.9f);
+    result.p99 = at(0.99f);
+    result.max = sorted[count - 1];
+    return result;
+}
+
+string Profiler::getPrometheusText()
+{
+    string result;
+    result += "# HELP emptyepsilon_section_seconds Time spent in a profiled section, over the most recent " + string(int(sample_count)) + " samples.\n";
+    result += "# TYPE emptyepsilon_section_seconds summary\n";
+    for(auto& section : sections)
+    {
+        auto labels = "group=\"" + section->group + "\",name=\"" + section->name + "\"";
+        auto p = getPercentiles(*section);
+        result += "emptyepsilon_section_seconds{" + labels + ",quantile=\"0.5\"} " + string(p.p50, 7) + "\n";
+        result += "emptyepsilon_section_seconds{" + labels + ",quantile=\"0.9\"} " + string(p.p90, 7) + "\n";
+        result += "emptyepsilon_section_seconds{" + labels + ",quantile=\"0.99\"} " + string(p.p99, 7) + "\n";
+        result += "emptyepsilon_section_seconds{" + labels + ",quantile=\"1\"} " + string(p.max, 7) + "\n";
+        result += "emptyepsilon_section_seconds_sum{" + labels + "} " + string(float(section->total), 7) + "\n";
+        result += "emptyepsilon_section_seconds_count{" + labels + "} " + string(std::to_string(section->count)) + "\n";
+    }
+    return result;
+}
@@ -0,0 +1,68 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "stringImproved.h"
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+
+// Timing of the hot paths of a tick: system updates, replication, scripts and rendering.
+// Each section keeps its most recent samples, from which the debug overlay and the /metrics
+// HTTP endpoint compute percentiles when asked. Only to be used from the main thread.
+class Profiler
+{
+public:
+    static constexpr size_t sample_count = 256;
+
+    struct Section
+    {
+        string group;
+        string name;
+        std::array<float, sample_count> samples{}; // In seconds, used as a ring buffer.
+        size_t sample_index = 0;
+        uint64_t count = 0;
+        double total = 0.0;
+
+        void add(float seconds)
+        {
+            samples[sample_index] = seconds;
+            sample_index = (sample_index + 1) % sample_count;
+            count++;
+            total += seconds;
+        }
+    };
+
+    struct Percentiles
+    {
+        float p50 = 0.0f;
+        float p90 = 0.0f;
+        float p99 = 0.0f;
+        float max = 0.0f;
+    };
+
+    class Scope
+    {
+    public:
+        explicit Scope(Section* section) : section(section), start(std::chrono::steady_clock::now()) {}
+        ~Scope() { section->add(std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count()); }
+    private:
+        Section* section;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    // Sections are never removed, so the returned pointer can be kept around. Look it up once, not per call.
+    static Section* getSection(const string& group, const string& name);
+    static const std::vector<std::unique_ptr<Section>>& getSections() { return sections; }
+
+    static Percentiles getPercentiles(const Section& section);
+    // All sections in the Prometheus text exposition format.
+    static string getPrometheusText();
+
+private:
+    static std::vector<std::unique_ptr<Section>> sections;
+};
+
+#endif//PROFILER_H
@@ -30,7 +30,7 @@ void GuiRotatingModelView::onDraw(sp::RenderTarget& renderer)
     if (rect.size.y <= 0) return;
 
     auto mrc = entity.getComponent<MeshRenderComponent>();
-    if (!mrc) return;
+    if (!mrc || !mrc->getMesh()) return;
 
     renderer.finish();
 
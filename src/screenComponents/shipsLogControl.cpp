@@ -1,4 +1,5 @@
 #include "playerInfo.h"
+#include "multiplayer_server.h"
 #include "components/shiplog.h"
 #include "shipsLogControl.h"
 
@@ -29,54 +30,54 @@ void ShipsLog::onDraw(sp::RenderTarget& renderer)
 
     if (open)
     {
-        if (log_text->getEntryCount() > 0 && logs->size() == 0)
-            log_text->clearEntries();
-
-        while(log_text->getEntryCount() > logs->size())
-        {
-            log_text->removeEntry(0);
-        }
-
-        if (log_text->getEntryCount() > 0 && logs->size() > 0 && log_text->getEntryText(0) != logs->get(0).text)
-        {
-            bool updated = false;
-            for(unsigned int n=1; n<log_text->getEntryCount(); n++)
-            {
-                if (log_text->getEntryText(n) == logs->get(0).text)
-                {
-                    for(unsigned int m=0; m<n; m++)
-                        log_text->removeEntry(0);
-                    updated = true;
-                    break;
-                }
-            }
-            if (!updated)
-                log_text->clearEntries();
-        }
-
-        while(log_text->getEntryCount() < logs->size())
-        {
-            int n = log_text->getEntryCount();
-            log_text->addEntry(logs->get(n).prefix, logs->get(n).text, logs->get(n).color, 0);
-        }
+        updateShipLogText(log_text, *logs, requested_seq);
     }else{
         if (log_text->getEntryCount() > 0 && logs->size() == 0)
             log_text->clearEntries();
         if (log_text->getEntryCount() > 0 && logs->size() > 0)
         {
-            if (log_text->getEntryText(0) != logs->get(logs->size()-1).text)
+            if (log_text->getEntryCount() > 1 || log_text->getEntrySeq(0) != logs->get(logs->size()-1).seq)
                 log_text->clearEntries();
         }
+        // Keep the real seq, so updateShipLogText sees this entry is not the start of the log once opened.
         if (log_text->getEntryCount() == 0 && logs->size() > 0) {
             const auto& back = logs->get(logs->size() - 1);
-            log_text->addEntry(back.prefix, back.text, back.color, 0);
+            log_text->addEntry(back.prefix, back.text, back.color, back.seq);
         }
     }
 }
 
+void updateShipLogText(GuiAdvancedScrollText* log_text, ShipLog& log, uint32_t& requested_seq)
+{
+    // Older entries showed up in front of what we have, or the log restarted, just rebuild the whole list.
+    auto count = log_text->getEntryCount();
+    if (count > 0 && (log.size() == 0 || log_text->getEntrySeq(0) > log.getFirstSeq() || log_text->getEntrySeq(count - 1) >= log.getNextSeq()))
+        log_text->clearEntries();
+
+    // Drop the entries that fell out of the log.
+    while(log_text->getEntryCount() > 0 && log_text->getEntrySeq(0) < log.getFirstSeq())
+        log_text->removeEntry(0);
+
+    count = log_text->getEntryCount();
+    uint32_t seq = count > 0 ? log_text->getEntrySeq(count - 1) + 1 : log.getFirstSeq();
+    for(; seq < log.getNextSeq(); seq++)
+    {
+        const auto& entry = log.get(seq - log.getFirstSeq());
+        log_text->addEntry(entry.prefix, entry.text, entry.color, entry.seq);
+    }
+
+    // Clients only get the most recent entries when joining, ask for the rest when the full log is shown.
+    if (!game_server && my_player_info && log.getFirstSeq() > log.history_first_seq && log.size() < ShipLog::max_entries && requested_seq != log.getFirstSeq())
+    {
+        requested_seq = log.getFirstSeq();
+        my_player_info->commandRequestShipLogHistory(requested_seq);
+    }
+}
+
 bool ShipsLog::onMouseDown(sp::io::Pointer::Button button, glm::vec2 position, sp::io::Pointer::ID id)
 {
     open = !open;
+    requested_seq = 0;
     if (open)
         setSize(getSize().x, 800);
     else
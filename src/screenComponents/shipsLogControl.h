@@ -5,6 +5,11 @@
 
 class GuiPanel;
 class GuiAdvancedScrollText;
+class ShipLog;
+
+// Bring the entries in the scroll text in line with the ship log, using the sequence numbers of the log entries.
+// When the log is not complete on this client, older entries are requested from the server.
+void updateShipLogText(GuiAdvancedScrollText* log_text, ShipLog& log, uint32_t& requested_seq);
 
 class ShipsLog : public GuiElement
 {
@@ -16,6 +21,7 @@ public:
 private:
     bool open;
     GuiAdvancedScrollText* log_text;
+    uint32_t requested_seq = 0;
 };
 
 #endif//SHIPS_LOG_CONTROL_H
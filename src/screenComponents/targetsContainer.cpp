@@ -198,6 +198,7 @@ void TargetsContainer::sortByDistance(glm::vec2 position, std::vector<sp::ecs::E
 bool TargetsContainer::isValidTarget(sp::ecs::Entity entity, ESelectionType selection_type)
 {
     if (entity == my_spaceship) return false;
+    if (visibility != VisibilityCache::Style::All && !VisibilityCache::isVisible(my_spaceship, visibility, entity)) return false;
 
     switch(selection_type)
     {
@@ -3,6 +3,7 @@
 
 #include "ecs/entity.h"
 #include "components/faction.h"
+#include "visibilityCache.h"
 
 class TargetsContainer
 {
@@ -17,6 +18,8 @@ public:
     TargetsContainer();
 
     void setAllowWaypointSelection() { allow_waypoint_selection = true; }
+    // Only allow selecting objects that are visible to our ship in this fog of war style.
+    void setVisibility(VisibilityCache::Style style) { visibility = style; }
 
     void clear();
     void add(sp::ecs::Entity obj);
@@ -35,6 +38,7 @@ private:
     std::vector<sp::ecs::Entity> entries;
     bool allow_waypoint_selection;
     int waypoint_selection_index;
+    VisibilityCache::Style visibility = VisibilityCache::Style::All;
 
     void setNext(glm::vec2 position, float max_range, std::vector<sp::ecs::Entity>& entities);
     void sortByDistance(glm::vec2 position, std::vector<sp::ecs::Entity>& entities);
@@ -12,6 +12,7 @@
 #include "preferenceManager.h"
 #include "particleEffect.h"
 #include "glObjects.h"
+#include "assetLoader.h"
 #include "shaderRegistry.h"
 #include "components/collision.h"
 #include "components/target.h"
@@ -29,9 +30,6 @@
 #include <glm/gtc/type_ptr.hpp>
 
 
-static std::unordered_map<string, std::unique_ptr<gl::CubemapTexture>> skybox_textures;
-
-
 GuiViewport3D::GuiViewport3D(GuiContainer* owner, string id)
 : GuiElement(owner, id)
 {
@@ -207,16 +205,8 @@ void GuiViewport3D::onDraw(sp::RenderTarget& renderer)
             }
         }
 
-        auto skybox_texture = skybox_textures[skybox_name].get();
-        if (!skybox_texture) {
-            skybox_textures[skybox_name] = std::make_unique<gl::CubemapTexture>(skybox_name);
-            skybox_texture = skybox_textures[skybox_name].get();
-        }
-        auto local_skybox_texture = skybox_textures[local_skybox_name].get();
-        if (!local_skybox_texture) {
-            skybox_textures[local_skybox_name] = std::make_unique<gl::CubemapTexture>(local_skybox_name);
-            local_skybox_texture = skybox_textures[local_skybox_name].get();
-        }
+        auto skybox_texture = AssetLoader::getCubemap(skybox_name);
+        auto local_skybox_texture = AssetLoader::getCubemap(local_skybox_name);
 
         // Setup shared state (uniforms)
         glUniform1i(starbox_uniforms[static_cast<size_t>(Uniforms::GlobalBox)], 0);
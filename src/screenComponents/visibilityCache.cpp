@@ -0,0 +1,98 @@
+#include "visibilityCache.h"
+#include "engine.h"
+#include "ecs/query.h"
+#include "systems/collision.h"
+#include "systems/radarblock.h"
+#include "components/collision.h"
+#include "components/faction.h"
+#include "components/radar.h"
+#include "components/radarblock.h"
+#include "glm/gtx/norm.hpp"
+
+
+namespace
+{
+    struct CacheEntry
+    {
+        bool valid = false;
+        sp::ecs::Entity viewer;
+        float tick = 0.0f;
+        sp::Bitset visible;
+    };
+    CacheEntry cache[3];
+}
+
+static void computeFriendlysShortRange(sp::ecs::Entity viewer, sp::Bitset& visible)
+{
+    if (!viewer)
+        return;
+
+    for(auto [entity, transform] : sp::ecs::Query<sp::Transform>())
+    {
+        // If the object can't hide in a nebula, it's considered visible.
+        if (entity.hasComponent<NeverRadarBlocked>()) {
+            visible.set(entity.getIndex());
+            continue;
+        }
+
+        // Only friendly objects that share their short-range radar reveal other objects.
+        if (!entity.hasComponent<ShareShortRangeRadar>())
+            continue;
+        if (Faction::getRelation(viewer, entity) != FactionRelation::Friendly)
+            continue;
+
+        // Reveal within short-range radar range, or 5U for objects without a radar.
+        float r = entity.getComponent<LongRangeRadar>() ? entity.getComponent<LongRangeRadar>()->short_range : 5000.0f;
+        auto position = transform.getPosition();
+
+        // Reveal objects that are at least partially inside the revealed radius.
+        for(auto entity2 : sp::CollisionSystem::queryArea(position - glm::vec2(r, r), position + glm::vec2(r, r)))
+        {
+            //TODO: This isn't great, as not everything will collision attached...
+            auto trace = entity2.getComponent<RadarTrace>();
+            float r2 = r + (trace ? trace->radius : 300.0f);
+            if (auto t2 = entity2.getComponent<sp::Transform>()) {
+                if (glm::length2(position - t2->getPosition()) < r2*r2)
+                    visible.set(entity2.getIndex());
+            }
+        }
+    }
+}
+
+const sp::Bitset& VisibilityCache::get(sp::ecs::Entity viewer, Style style)
+{
+    auto& entry = cache[static_cast<int>(style)];
+    float tick = engine->getElapsedTime();
+    // The game time stands still while paused, but the GM can still move things around.
+    if (entry.valid && entry.viewer == viewer && entry.tick == tick && engine->getGameSpeed() != 0.0f)
+        return entry.visible;
+
+    entry.valid = true;
+    entry.viewer = viewer;
+    entry.tick = tick;
+    entry.visible = sp::Bitset();
+    switch(style)
+    {
+    case Style::All:
+        for(auto [entity, transform] : sp::ecs::Query<sp::Transform>())
+            entry.visible.set(entity.getIndex());
+        break;
+    case Style::Nebula:
+        if (auto transform = viewer.getComponent<sp::Transform>())
+        {
+            auto lrr = viewer.getComponent<LongRangeRadar>();
+            auto short_range = lrr ? lrr->short_range : 5000.0f;
+            RadarBlockSystem::getVisibleFrom(transform->getPosition(), short_range, entry.visible);
+        }
+        break;
+    case Style::FriendlysShortRange:
+        computeFriendlysShortRange(viewer, entry.visible);
+        break;
+    }
+    return entry.visible;
+}
+
+bool VisibilityCache::isVisible(sp::ecs::Entity viewer, Style style, sp::ecs::Entity entity)
+{
+    return entity && get(viewer, style).has(entity.getIndex());
+}
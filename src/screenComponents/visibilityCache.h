@@ -0,0 +1,25 @@
+#ifndef VISIBILITY_CACHE_H
+#define VISIBILITY_CACHE_H
+
+#include "ecs/entity.h"
+#include "container/bitset.h"
+
+// Fog of war visibility as seen by a ship. Computed at most once per game tick,
+// so all radar views and target selections of a screen share the same result.
+// The game tick is the whole invalidation key: which transforms contribute depends on the result itself,
+// as any object that moves can enter or leave a revealed area, so tracking them would cost as much as recomputing.
+class VisibilityCache
+{
+public:
+    enum class Style
+    {
+        All,                 // Everything with a transform is visible.
+        Nebula,              // Everything that is not hidden from the viewer by a nebula.
+        FriendlysShortRange, // Everything within short-range radar range of a friendly that shares its radar.
+    };
+
+    static const sp::Bitset& get(sp::ecs::Entity viewer, Style style);
+    static bool isVisible(sp::ecs::Entity viewer, Style style, sp::ecs::Entity entity);
+};
+
+#endif//VISIBILITY_CACHE_H
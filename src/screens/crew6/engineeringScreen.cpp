@@ -120,25 +120,25 @@ EngineeringScreen::EngineeringScreen(GuiContainer* owner, CrewPosition crew_posi
         auto coolant = my_spaceship.getComponent<Coolant>();
         if (!coolant) return;
         float new_max_total = coolant->max - requested_unused_coolant;
-        for(int n=0; n<ShipSystem::COUNT; n++) {
-            auto sys = ShipSystem::get(my_spaceship, ShipSystem::Type(n));
+        auto systems = ShipSystem::getAll(my_spaceship);
+        for(auto sys : systems) {
             if (sys)
                 total_requested += sys->coolant_request;
         }
         if (new_max_total < total_requested) { // Drain systems
             for(int n=0; n<ShipSystem::COUNT; n++) {
-                auto sys = ShipSystem::get(my_spaceship, ShipSystem::Type(n));
+                auto sys = systems[n];
                 if (sys)
                     my_player_info->commandSetSystemCoolantRequest(ShipSystem::Type(n), sys->coolant_request * new_max_total / total_requested);
             }
         } else { // Put coolant into systems
             int system_count = 0;
-            for(int n=0; n<ShipSystem::COUNT; n++)
-                if (ShipSystem::get(my_spaceship, ShipSystem::Type(n)))
+            for(auto sys : systems)
+                if (sys)
                     system_count += 1;
             float add = (new_max_total - total_requested) / float(system_count);
             for(int n=0; n<ShipSystem::COUNT; n++) {
-                auto sys = ShipSystem::get(my_spaceship, ShipSystem::Type(n));
+                auto sys = systems[n];
                 if (sys)
                     my_player_info->commandSetSystemCoolantRequest(ShipSystem::Type(n), std::min(sys->coolant_request + add, 10.0f));
             }
@@ -12,6 +12,7 @@
 #include "components/name.h"
 
 #include "screenComponents/radarView.h"
+#include "screenComponents/visibilityCache.h"
 #include "screenComponents/openCommsButton.h"
 #include "screenComponents/commsOverlay.h"
 #include "screenComponents/shipsLogControl.h"
@@ -40,6 +41,7 @@ RelayScreen::RelayScreen(GuiContainer* owner, bool allow_comms)
 : GuiOverlay(owner, "RELAY_SCREEN", colorConfig.background)
 {
     targets.setAllowWaypointSelection();
+    targets.setVisibility(VisibilityCache::Style::FriendlysShortRange);
     radar = new GuiRadarView(this, "RELAY_RADAR", 50000.0f, &targets);
     radar->longRange()->enableWaypoints()->enableCallsigns()->setStyle(GuiRadarView::Rectangular)->setFogOfWarStyle(GuiRadarView::FriendlysShortRangeFogOfWar);
     radar->setAutoCentering(false);
@@ -237,6 +239,8 @@ void RelayScreen::onDraw(sp::RenderTarget& renderer)
     {
         // Check each object to determine whether the target is still within
         // shared radar range of a friendly object.
+        // This is stricter than the radar's fog of war in VisibilityCache, which also counts the radius of the target
+        // and objects that cannot hide in a nebula. It is a single target, so it is not worth caching.
         auto target = targets.get();
         bool near_friendly = false;
 
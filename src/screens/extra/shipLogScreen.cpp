@@ -4,6 +4,7 @@
 
 #include "gui/gui2_advancedscrolltext.h"
 #include "screenComponents/customShipFunctions.h"
+#include "screenComponents/shipsLogControl.h"
 
 
 ShipLogScreen::ShipLogScreen(GuiContainer* owner)
@@ -33,36 +34,6 @@ void ShipLogScreen::onDraw(sp::RenderTarget& renderer)
         auto logs = my_spaceship.getComponent<ShipLog>();
         if (!logs)
             return;
-        if (log_text->getEntryCount() > 0 && logs->size() == 0)
-            log_text->clearEntries();
-
-        while(log_text->getEntryCount() > logs->size())
-        {
-            log_text->removeEntry(0);
-        }
-
-        if (log_text->getEntryCount() > 0 && logs->size() > 0 && log_text->getEntryText(0) != logs->get(0).text)
-        {
-            bool updated = false;
-            for(unsigned int n=1; n<log_text->getEntryCount(); n++)
-            {
-                if (log_text->getEntryText(n) == logs->get(0).text)
-                {
-                    for(unsigned int m=0; m<n; m++)
-                        log_text->removeEntry(0);
-                    updated = true;
-                    break;
-                }
-            }
-            if (!updated)
-                log_text->clearEntries();
-        }
-
-        while(log_text->getEntryCount() < logs->size())
-        {
-            int n = log_text->getEntryCount();
-            const auto& entry = logs->get(n);
-            log_text->addEntry(entry.prefix, entry.text, entry.color, 0);
-        }
+        updateShipLogText(log_text, *logs, requested_seq);
     }
 }
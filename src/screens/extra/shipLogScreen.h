@@ -11,6 +11,7 @@ class ShipLogScreen : public GuiOverlay
 private:
     GuiAdvancedScrollText* log_text;
     GuiCustomShipFunctions* custom_function_sidebar;
+    uint32_t requested_seq = 0;
 public:
     ShipLogScreen(GuiContainer* owner);
 
@@ -1125,11 +1125,66 @@ static void luaStartThread(sp::script::Callback callback)
         gameGlobalInfo->new_script_threads.push_back(res.value());
 }
 
+ScriptYieldRequest script_yield_request;
+
+ScriptThreadCondition::ScriptThreadCondition(lua_State* L, int ref)
+: L(L), ref(ref)
+{
+}
+
+ScriptThreadCondition::~ScriptThreadCondition()
+{
+    luaL_unref(L, LUA_REGISTRYINDEX, ref);
+}
+
+bool ScriptThreadCondition::check()
+{
+    lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
+    if (lua_pcall(L, 0, 1, 0) != LUA_OK)
+    {
+        LuaConsole::addLog(string("Script thread condition error: ") + lua_tostring(L, -1));
+        lua_pop(L, 1);
+        return true;
+    }
+    bool result = lua_toboolean(L, -1);
+    lua_pop(L, 1);
+    return result;
+}
+
 static int luaYield(lua_State* lua)
 {
+    script_yield_request = {};
+    int arg = 1;
+    if (lua_isfunction(lua, 1))
+    {
+        //The condition is called while no thread runs, so on the main Lua thread.
+        lua_rawgeti(lua, LUA_REGISTRYINDEX, LUA_RIDX_MAINTHREAD);
+        lua_State* main_thread = lua_tothread(lua, -1);
+        lua_pop(lua, 1);
+        lua_pushvalue(lua, 1);
+        script_yield_request.condition = std::make_shared<ScriptThreadCondition>(main_thread, luaL_ref(lua, LUA_REGISTRYINDEX));
+        arg = 2;
+    }
+    if (lua_isnumber(lua, arg))
+        script_yield_request.delay = lua_tonumber(lua, arg);
+
+    //The bottom of the stack is the function the thread was started with.
+    lua_Debug ar;
+    int level = 0;
+    while(lua_getstack(lua, level + 1, &ar))
+        level++;
+    if (level > 0 && lua_getstack(lua, level, &ar) && lua_getinfo(lua, "S", &ar))
+        script_yield_request.location = string(ar.short_src) + ":" + string(ar.linedefined);
     return lua_yield(lua, 0);
 }
 
+static string luaGetScriptThreadStats()
+{
+    if (!gameGlobalInfo)
+        return "";
+    return gameGlobalInfo->getScriptThreadStats();
+}
+
 void setupSubEnvironment(sp::script::Environment& env)
 {
     env.setGlobalFuncWithEnvUpvalue("require", &luaRequire);
@@ -1154,7 +1209,18 @@ bool setupScriptEnvironment(sp::script::Environment& env)
     env.setGlobal("getEntitiesWithComponent", &luaQueryEntities);
     env.setGlobal("getLuaEntityFunctionTable", &luaGetEntityFunctionTable);
     env.setGlobal("startThread", &luaStartThread);
+    /// float yield([function condition], [float seconds])
+    /// Pauses a thread started with startThread. Without arguments it continues on the next update.
+    /// With seconds it continues after that much game time has passed, and with a condition once the condition function returns true.
+    /// With both, the condition is only checked every that many seconds.
+    /// Returns the delta time of the update in which the thread continues.
+    /// Examples:
+    ///   startThread(function() while true do spawnWave() yield(60) end end)
+    ///   startThread(function() yield(function() return not player:isValid() end) victory("Kraylor") end)
     env.setGlobal("yield", &luaYield);
+    /// string getScriptThreadStats()
+    /// Returns how much time the running script threads take, per function that started them. Useful from the Lua console to find slow scenario code.
+    env.setGlobal("getScriptThreadStats", &luaGetScriptThreadStats);
     
     env.setGlobal("createClass", &luaCreateClass);
 
@@ -2,8 +2,34 @@
 #define SCRIPT_H
 
 #include "script/environment.h"
+#include <memory>
+
+struct lua_State;
 
 void setupSubEnvironment(sp::script::Environment& env);
 bool setupScriptEnvironment(sp::script::Environment& env);
 
+//Lua function a script thread waits for, the thread continues once it returns true.
+class ScriptThreadCondition
+{
+public:
+    ScriptThreadCondition(lua_State* L, int ref);
+    ~ScriptThreadCondition();
+
+    //Errors are logged, and let the thread continue so the scenario does not silently hang.
+    bool check();
+private:
+    lua_State* L;
+    int ref;
+};
+
+//What a script thread asked for with yield(), GameGlobalInfo picks it up after resuming the thread.
+struct ScriptYieldRequest
+{
+    float delay = 0.0f;
+    std::shared_ptr<ScriptThreadCondition> condition;
+    string location; //Function the thread runs, for the thread statistics.
+};
+extern ScriptYieldRequest script_yield_request;
+
 #endif//SCRIPT_H
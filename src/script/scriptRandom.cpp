@@ -1,6 +1,10 @@
 #include "scriptRandom.h"
 #include "random.h"
 #include <random>
+#include <memory>
+
+// Only set when seeded, the engine wide random() is used otherwise.
+static std::unique_ptr<std::mt19937_64> seeded_rng;
 
 static int lua_rngSeed(lua_State* L)
 {
@@ -57,7 +61,10 @@ int lua_random(lua_State* L) {
     auto b = luaL_checknumber(L, -1);
     if (a > b)
         return luaL_error(L, "bad call random(%f, %f): lower bound is greater than upper bound", a, b);
-    lua_pushnumber(L, random(a, b));
+    if (seeded_rng)
+        lua_pushnumber(L, std::uniform_real_distribution<float>(a, b)(*seeded_rng));
+    else
+        lua_pushnumber(L, random(a, b));
     return 1;
 }
 
@@ -66,10 +73,18 @@ int lua_irandom(lua_State* L) {
     auto b = luaL_checkinteger(L, -1);
     if (a > b)
         return luaL_error(L, "bad call irandom(%d, %d): lower bound is greater than upper bound", a, b);
-    lua_pushinteger(L, irandom(a, b));
+    if (seeded_rng)
+        lua_pushinteger(L, std::uniform_int_distribution<>(a, b)(*seeded_rng));
+    else
+        lua_pushinteger(L, irandom(a, b));
     return 1;
 }
 
+void seedScriptRandom(uint64_t seed)
+{
+    seeded_rng = std::make_unique<std::mt19937_64>(seed);
+}
+
 void registerScriptRandomFunctions(sp::script::Environment& env)
 {
     env.setGlobal("random", &lua_random);
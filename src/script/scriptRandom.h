@@ -1,4 +1,6 @@
 #pragma once
 #include "script/environment.h"
 
-void registerScriptRandomFunctions(sp::script::Environment& env);
\ No newline at end of file
+void registerScriptRandomFunctions(sp::script::Environment& env);
+// Make the script random() and irandom() functions repeatable, for benchmarks and regression runs.
+void seedScriptRandom(uint64_t seed);
\ No newline at end of file
@@ -0,0 +1,45 @@
+#include "simulationClock.h"
+#include "engine.h"
+
+#include <algorithm>
+#include <thread>
+
+
+SimulationClock::SimulationClock(float tick_rate, float time_warp)
+{
+    if (tick_rate <= 0.0f)
+        tick_rate = 60.0f;
+    fixed_step = 1.0f / tick_rate;
+    frame_period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(fixed_step / std::max(time_warp, 0.01f)));
+    next_frame = last_frame = std::chrono::steady_clock::now();
+}
+
+SimulationClock::~SimulationClock()
+{
+    fixed_step = 0.0f;
+}
+
+void SimulationClock::update(float delta)
+{
+    // Paused, by the GM, a script or the server startup. Unpausing sets the speed to 1 and we take over from there.
+    if (engine->getGameSpeed() <= 0.0f)
+    {
+        next_frame = last_frame = std::chrono::steady_clock::now();
+        return;
+    }
+
+    // One step per frame, so hold frames to the warped step. A frame that took longer just runs the simulation slower.
+    auto now = std::chrono::steady_clock::now();
+    if (now < next_frame)
+    {
+        std::this_thread::sleep_until(next_frame);
+        now = next_frame;
+    }
+    next_frame = std::max(next_frame + frame_period, now);
+
+    // The engine scales the next frame time, clamped to this range, by the game speed. Paced frames all take
+    // about as long as the last one, slower frames are followed by a slightly off physics step.
+    float frame_time = std::clamp(std::chrono::duration<float>(now - last_frame).count(), 0.001f, 0.5f);
+    last_frame = now;
+    engine->setGameSpeed(fixed_step / frame_time);
+}
@@ -0,0 +1,37 @@
+#ifndef SIMULATION_CLOCK_H
+#define SIMULATION_CLOCK_H
+
+#include "Updatable.h"
+
+#include <chrono>
+
+
+// Lets a headless server simulate faster than real time, for balance tests and scenario regression runs.
+// SeriousProton owns the main loop and turns the wall clock time of a frame into the tick delta, so this
+// clock hooks in on our side instead: every engine tick advances the ECS systems and the scenario scripts by
+// exactly one fixed step (1 / tick_rate, see tickDelta), and frames are paced so the simulation runs at most
+// time_warp times faster than real time. A time warp without a tick rate uses 60 ticks per second, so the
+// step never grows with the wall clock time of a frame.
+// The engine's own consumers of the delta (physics and engine->getElapsedTime) are steered with the game
+// speed to follow the same step, which is only exact while frames are paced.
+class SimulationClock : public Updatable
+{
+public:
+    SimulationClock(float tick_rate, float time_warp);
+    virtual ~SimulationClock();
+
+    virtual void update(float delta) override;
+
+    // The delta the systems and scripts advance by, for an engine tick of the given delta.
+    // The fixed step while a simulation clock runs, else the delta itself. Pausing still stops everything.
+    static float tickDelta(float delta) { return (fixed_step > 0.0f && delta > 0.0f) ? fixed_step : delta; }
+
+private:
+    static inline float fixed_step = 0.0f;
+
+    std::chrono::steady_clock::duration frame_period;
+    std::chrono::steady_clock::time_point next_frame;
+    std::chrono::steady_clock::time_point last_frame;
+};
+
+#endif//SIMULATION_CLOCK_H
@@ -2,16 +2,56 @@
 #include "components/ai.h"
 #include "ecs/query.h"
 #include "multiplayer_server.h"
+#include "preferenceManager.h"
 #include "ai/ai.h"
 #include "ai/aiFactory.h"
 
 
+AISystem::AISystem()
+{
+    int thread_count = PreferencesManager::get("ai_threads", "0").toInt();
+    if (thread_count < 1)
+        return;
+    parallel = true;
+    for(int n=1; n<thread_count; n++)
+        workers.emplace_back(&AISystem::workerLoop, this);
+}
+
+AISystem::~AISystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop_workers = true;
+    }
+    work_available.notify_all();
+    for(auto& worker : workers)
+        worker.join();
+}
+
 void AISystem::update(float delta)
 {
     if (delta <= 0.0f) return;
     if (!game_server)
         return;
 
+    if (!parallel)
+    {
+        for(auto [entity, ai] : sp::ecs::Query<AIController>()) {
+            if (ai.new_name.length() && (!ai.ai || ai.ai->canSwitchAI()))
+            {
+                auto f = ShipAIFactory::getAIFactory(ai.new_name);
+                ai.ai = nullptr;
+                if (f)
+                    ai.ai = f(entity);
+                ai.new_name = "";
+            }
+            if (ai.ai)
+                ai.ai->run(delta);
+        }
+        return;
+    }
+
+    thinking.clear();
     for(auto [entity, ai] : sp::ecs::Query<AIController>()) {
         if (ai.new_name.length() && (!ai.ai || ai.ai->canSwitchAI()))
         {
@@ -22,6 +62,63 @@ void AISystem::update(float delta)
             ai.new_name = "";
         }
         if (ai.ai)
+            thinking.push_back(ai.ai.get());
+    }
+
+    // Copy everything the think phase reads, so the worker threads never touch the components or the physics world.
+    ShipAI::prepareThinkTargets();
+    for(auto ai : thinking)
+        ai->prepareThink();
+    thinkAll();
+
+    for(auto [entity, ai] : sp::ecs::Query<AIController>()) {
+        if (ai.ai) {
             ai.ai->run(delta);
+            ai.ai->clearThinkResults();
+        }
+    }
+}
+
+void AISystem::thinkAll()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        think_index = 0;
+        busy_workers = workers.size();
+        generation++;
+    }
+    work_available.notify_all();
+    thinkJobs();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    work_done.wait(lock, [this]() { return busy_workers == 0; });
+}
+
+void AISystem::thinkJobs()
+{
+    while(true)
+    {
+        size_t index = think_index++;
+        if (index >= thinking.size())
+            return;
+        thinking[index]->think();
+    }
+}
+
+void AISystem::workerLoop()
+{
+    int seen_generation = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while(true)
+    {
+        work_available.wait(lock, [this, &seen_generation]() { return stop_workers || generation != seen_generation; });
+        if (stop_workers)
+            return;
+        seen_generation = generation;
+        lock.unlock();
+        thinkJobs();
+        lock.lock();
+        if (--busy_workers == 0)
+            work_done.notify_one();
     }
 }
@@ -1,10 +1,37 @@
 #pragma once
 
 #include "ecs/system.h"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 
+class ShipAI;
 class AISystem : public sp::ecs::System
 {
 public:
+    AISystem();
+    virtual ~AISystem();
+
     void update(float delta) override;
+
+private:
+    // When the "ai_threads" preference is set, each AI first thinks on a worker pool from a copy of the world made on the main thread,
+    // and then runs serially. The think results only depend on the world state, so they do not depend on the thread count.
+    bool parallel = false;
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::condition_variable work_done;
+    std::vector<ShipAI*> thinking;
+    std::atomic<size_t> think_index{0};
+    int generation = 0;
+    size_t busy_workers = 0;
+    bool stop_workers = false;
+
+    void thinkAll();
+    void thinkJobs();
+    void workerLoop();
 };
@@ -14,10 +14,10 @@ void EnergySystem::update(float delta)
     for(auto[entity, reactor] : sp::ecs::Query<Reactor>()) {
         // Consume power based on subsystem requests and state.
         float net_power = 0.0;
+        auto systems = ShipSystem::getAll(entity);
         // Determine each subsystem's energy draw.
-        for(int n = 0; n < ShipSystem::COUNT; n++)
+        for(auto sys : systems)
         {
-            const auto sys = ShipSystem::get(entity, ShipSystem::Type(n));
             if (!sys) continue;
             // Factor the subsystem's health into energy generation.
             auto power_user_factor = sys->power_factor * sys->power_factor_rate;
@@ -42,12 +42,8 @@ void EnergySystem::update(float delta)
         if (reactor.energy < 10) {
             // Depower all systems except the reactor once energy level drops below 10.
             for(int n=0; n<ShipSystem::COUNT; n++) {
-                auto type = ShipSystem::Type(n);
-                if (type != ShipSystem::Type::Reactor) {
-                    auto system = ShipSystem::get(entity, type);
-                    if (system)
-                        system->power_request = 0;
-                }
+                if (ShipSystem::Type(n) != ShipSystem::Type::Reactor && systems[n])
+                    systems[n]->power_request = 0;
             }
         }
 
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "ecs/system.h"
+
+
+class FactionSystem : public sp::ecs::System
+{
+public:
+    void update(float delta) override;
+};
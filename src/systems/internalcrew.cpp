@@ -4,35 +4,167 @@
 #include "multiplayer_server.h"
 #include "random.h"
 
-#include <glm/gtx/hash.hpp>
-#include "astar.h"
-
-static InternalRooms* pathfind_rooms;
-
-static std::vector<std::pair<glm::ivec2, float>> astarGetNeighbors(glm::ivec2 pos) {
-    std::vector<std::pair<glm::ivec2, float>> result;
-    for(auto& room : pathfind_rooms->rooms) {
-        if (pos.x >= room.position.x && pos.x < room.position.x + room.size.x && pos.y >= room.position.y && pos.y < room.position.y + room.size.y) {
-            if (pos.x > room.position.x) result.push_back({pos + glm::ivec2{-1, 0}, 1.0f});
-            if (pos.x < room.position.x + room.size.x - 1) result.push_back({pos + glm::ivec2{1, 0}, 1.0f});
-            if (pos.y > room.position.y) result.push_back({pos + glm::ivec2{0, -1}, 1.0f});
-            if (pos.y < room.position.y + room.size.y - 1) result.push_back({pos + glm::ivec2{0, 1}, 1.0f});
-            break;
+#include <algorithm>
+
+// Directions in the navigation link bits, the door bit of a direction is the link bit shifted by door_shift.
+static const glm::ivec2 link_offsets[4] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+static constexpr int link_left = 0, link_right = 1, link_up = 2, link_down = 3;
+static constexpr int door_shift = 4;
+static constexpr size_t max_cached_steps = 16384;
+
+static bool navigationMatches(const InternalRooms& ir)
+{
+    auto& nav = ir.navigation;
+    if (nav.rooms.size() != ir.rooms.size() || nav.doors.size() != ir.doors.size())
+        return false;
+    for(size_t n=0; n<ir.rooms.size(); n++)
+        if (nav.rooms[n].position != ir.rooms[n].position || nav.rooms[n].size != ir.rooms[n].size)
+            return false;
+    for(size_t n=0; n<ir.doors.size(); n++)
+        if (nav.doors[n].position != ir.doors[n].position || nav.doors[n].horizontal != ir.doors[n].horizontal)
+            return false;
+    return true;
+}
+
+static void buildNavigation(InternalRooms& ir)
+{
+    auto& nav = ir.navigation;
+    nav.rooms = ir.rooms;
+    nav.doors = ir.doors;
+    nav.origin = ir.roomMin();
+    nav.size = ir.roomMax() - nav.origin;
+    int cell_count = nav.size.x * nav.size.y;
+    auto inside = [&nav](glm::ivec2 p) { return p.x >= 0 && p.y >= 0 && p.x < nav.size.x && p.y < nav.size.y; };
+    auto index = [&nav](glm::ivec2 p) { return p.x + p.y * nav.size.x; };
+
+    // Within a room, crew can walk to every neighbouring cell of the same room. Where rooms overlap, the first one counts.
+    nav.links.assign(cell_count, 0);
+    std::vector<bool> in_room(cell_count, false);
+    for(auto& room : ir.rooms) {
+        for(int y=0; y<room.size.y; y++) {
+            for(int x=0; x<room.size.x; x++) {
+                auto p = room.position - nav.origin + glm::ivec2{x, y};
+                if (in_room[index(p)])
+                    continue;
+                in_room[index(p)] = true;
+                uint8_t links = 0;
+                if (x > 0) links |= 1 << link_left;
+                if (x < room.size.x - 1) links |= 1 << link_right;
+                if (y > 0) links |= 1 << link_up;
+                if (y < room.size.y - 1) links |= 1 << link_down;
+                nav.links[index(p)] = links;
+            }
         }
     }
-    for(auto& door : pathfind_rooms->doors) {
-        if (door.horizontal) {
-            if (door.position == pos) result.push_back({pos + glm::ivec2{0, -1}, 1.1f});
-            if (door.position == pos + glm::ivec2{0, 1}) result.push_back({pos + glm::ivec2{0, 1}, 1.1f});
-        } else {
-            if (door.position == pos) result.push_back({pos + glm::ivec2{-1, 0}, 1.1f});
-            if (door.position == pos + glm::ivec2{1, 0}) result.push_back({pos + glm::ivec2{1, 0}, 1.1f});
+    // A door connects the cell it is on with the cell above it, or left of it.
+    for(auto& door : ir.doors) {
+        auto a = door.position - nav.origin;
+        auto b = a + (door.horizontal ? glm::ivec2{0, -1} : glm::ivec2{-1, 0});
+        if (!inside(a) || !inside(b))
+            continue;
+        int a_to_b = door.horizontal ? link_up : link_left;
+        int b_to_a = door.horizontal ? link_down : link_right;
+        if (!(nav.links[index(a)] & (1 << a_to_b)))
+            nav.links[index(a)] |= (1 << a_to_b) | (1 << (a_to_b + door_shift));
+        if (!(nav.links[index(b)] & (1 << b_to_a)))
+            nav.links[index(b)] |= (1 << b_to_a) | (1 << (b_to_a + door_shift));
+    }
+
+    nav.next_step.clear();
+    nav.cost.assign(cell_count, 0.0f);
+    nav.came_from.assign(cell_count, -1);
+    nav.visited.assign(cell_count, 0);
+    nav.search = 0;
+    nav.open.clear();
+    nav.open.reserve(cell_count * 4 + 1);
+}
+
+// A* search over the navigation cells. Caches the next step towards the target for every cell on the found path,
+// so crews walking that path, or other crews heading the same way, do not search again.
+static int findNextStep(InternalRooms::Navigation& nav, int from, int to)
+{
+    auto key = [](int a, int b) { return uint64_t(uint32_t(a)) << 32 | uint32_t(b); };
+    auto it = nav.next_step.find(key(from, to));
+    if (it != nav.next_step.end())
+        return it->second;
+    if (nav.next_step.size() >= max_cached_steps)
+        nav.next_step.clear();
+
+    if (++nav.search == 0) {
+        std::fill(nav.visited.begin(), nav.visited.end(), 0);
+        nav.search = 1;
+    }
+    auto position = [&nav](int cell) { return glm::vec2(cell % nav.size.x, cell / nav.size.x); };
+    auto target = position(to);
+    auto heuristic = [&](int cell) { return glm::length(target - position(cell)); };
+    // Min heap on the estimated total cost.
+    auto compare = [](const std::pair<float, int>& a, const std::pair<float, int>& b) { return a.first > b.first; };
+
+    nav.open.clear();
+    nav.cost[from] = 0.0f;
+    nav.came_from[from] = -1;
+    nav.visited[from] = nav.search;
+    nav.open.push_back({heuristic(from), from});
+    bool found = false;
+    while(!nav.open.empty()) {
+        std::pop_heap(nav.open.begin(), nav.open.end(), compare);
+        auto [estimate, cell] = nav.open.back();
+        nav.open.pop_back();
+        if (cell == to) {
+            found = true;
+            break;
         }
+        // Cells get pushed again when a cheaper way to them is found, skip the outdated entries.
+        if (estimate > nav.cost[cell] + heuristic(cell) + 0.001f)
+            continue;
+        auto links = nav.links[cell];
+        auto p = glm::ivec2(cell % nav.size.x, cell / nav.size.x);
+        for(int direction=0; direction<4; direction++) {
+            if (!(links & (1 << direction)))
+                continue;
+            auto n = p + link_offsets[direction];
+            int next = n.x + n.y * nav.size.x;
+            float cost = nav.cost[cell] + ((links & (1 << (direction + door_shift))) ? 1.1f : 1.0f);
+            if (nav.visited[next] == nav.search && cost >= nav.cost[next])
+                continue;
+            nav.visited[next] = nav.search;
+            nav.cost[next] = cost;
+            nav.came_from[next] = cell;
+            if (nav.open.size() == nav.open.capacity())
+                break; // Cannot happen with consistent costs, but never allocate during the search.
+            nav.open.push_back({cost + heuristic(next), next});
+            std::push_heap(nav.open.begin(), nav.open.end(), compare);
+        }
+    }
+    if (!found) {
+        nav.next_step[key(from, to)] = -1;
+        return -1;
     }
-    return result;
+    int step = to;
+    for(int cell = nav.came_from[to]; cell != -1; cell = nav.came_from[cell]) {
+        nav.next_step[key(cell, to)] = step;
+        step = cell;
+    }
+    return nav.next_step[key(from, to)];
 }
 
-static float astarGetDistance(glm::ivec2 a, glm::ivec2 b) { return glm::length(glm::vec2(b - a)); }
+static bool findNextStep(InternalRooms& ir, glm::ivec2 from, glm::ivec2 to, glm::ivec2& next)
+{
+    if (!navigationMatches(ir))
+        buildNavigation(ir);
+    auto& nav = ir.navigation;
+    from -= nav.origin;
+    to -= nav.origin;
+    if (from.x < 0 || from.y < 0 || from.x >= nav.size.x || from.y >= nav.size.y)
+        return false;
+    if (to.x < 0 || to.y < 0 || to.x >= nav.size.x || to.y >= nav.size.y)
+        return false;
+    int step = findNextStep(nav, from.x + from.y * nav.size.x, to.x + to.y * nav.size.x);
+    if (step < 0)
+        return false;
+    next = nav.origin + glm::ivec2(step % nav.size.x, step / nav.size.x);
+    return true;
+}
 
 void InternalCrewSystem::update(float delta)
 {
@@ -69,14 +201,13 @@ void InternalCrewSystem::update(float delta)
                 ic.action_delay = 1.0f / ic.move_speed;
                 if (pos != ic.target_position)
                 {
-                    pathfind_rooms = ir;
-                    auto path = astar(pos, ic.target_position, astarGetNeighbors, astarGetDistance);
-                    if (path.size() > 0) {
+                    glm::ivec2 next;
+                    if (findNextStep(*ir, pos, ic.target_position, next)) {
                         ic.action = InternalCrew::Action::Move;
-                        if (path[0].x > pos.x) ic.direction = InternalCrew::Direction::Right;
-                        if (path[0].x < pos.x) ic.direction = InternalCrew::Direction::Left;
-                        if (path[0].y > pos.y) ic.direction = InternalCrew::Direction::Down;
-                        if (path[0].y < pos.y) ic.direction = InternalCrew::Direction::Up;
+                        if (next.x > pos.x) ic.direction = InternalCrew::Direction::Right;
+                        if (next.x < pos.x) ic.direction = InternalCrew::Direction::Left;
+                        if (next.y > pos.y) ic.direction = InternalCrew::Direction::Down;
+                        if (next.y < pos.y) ic.direction = InternalCrew::Direction::Up;
                     }
                 }
                 ic.position = glm::vec2{pos.x, pos.y};
@@ -10,11 +10,20 @@ const float small_object_max_size = 1000.0f;
 static PathFindingSystem* path_finding_system;
 
 
-static uint32_t hashPosition(glm::vec2 position)
+static glm::ivec2 gridCell(glm::vec2 position)
 {
-    uint32_t x = std::floor(position.x / small_object_grid_size);
-    uint32_t y = std::floor(position.y / small_object_grid_size);
-    return x ^ (y << 16);
+    return {int(std::floor(position.x / small_object_grid_size)), int(std::floor(position.y / small_object_grid_size))};
+}
+
+static uint64_t gridKey(int x, int y)
+{
+    return (uint64_t(uint32_t(x)) << 32) | uint64_t(uint32_t(y));
+}
+
+static uint64_t gridKey(glm::vec2 position)
+{
+    auto cell = gridCell(position);
+    return gridKey(cell.x, cell.y);
 }
 
 PathFindingSystem::PathFindingSystem()
@@ -26,8 +35,15 @@ void PathFindingSystem::update(float delta)
 {
     // Remove any entities that where destroyed.
     big_entities.erase(std::remove_if(big_entities.begin(), big_entities.end(), [](sp::ecs::Entity e) { return !bool(e); } ), big_entities.end());
-    for(auto it : small_entities)
-        it.second.erase(std::remove_if(it.second.begin(), it.second.end(), [](sp::ecs::Entity e) { return !bool(e); } ), it.second.end());
+    for(auto it = small_entities.begin(); it != small_entities.end(); )
+    {
+        auto& list = it->second;
+        list.erase(std::remove_if(list.begin(), list.end(), [](sp::ecs::Entity e) { return !bool(e); } ), list.end());
+        if (list.empty())
+            it = small_entities.erase(it);
+        else
+            ++it;
+    }
 
     for(auto [entity, dao] : sp::ecs::Query<DelayedAvoidObject>()) {
         dao.delay -= delta;
@@ -45,25 +61,64 @@ void PathFindingSystem::update(float delta)
                 big_entities.push_back(entity);
                 ao.state = AvoidObject::InternalState::BigEntity;
             } else {
-                ao.position_hash = hashPosition(transform.getPosition());
-                small_entities[ao.position_hash].push_back(entity);
+                ao.grid_key = gridKey(transform.getPosition());
+                small_entities[ao.grid_key].push_back(entity);
                 ao.state = AvoidObject::InternalState::SmallEntity;
             }
             break;
         case AvoidObject::InternalState::BigEntity:
             break;
         case AvoidObject::InternalState::SmallEntity:
-            if (ao.position_hash != hashPosition(transform.getPosition())) {
-                auto& so = small_entities[ao.position_hash];
-                so.erase(std::remove_if(so.begin(), so.end(), [oe=entity](sp::ecs::Entity e) { return e == oe; } ), so.end());
-                ao.position_hash = hashPosition(transform.getPosition());
-                small_entities[ao.position_hash].push_back(entity);
+            if (auto key = gridKey(transform.getPosition()); ao.grid_key != key) {
+                auto it = small_entities.find(ao.grid_key);
+                if (it != small_entities.end()) {
+                    auto& so = it->second;
+                    so.erase(std::remove_if(so.begin(), so.end(), [oe=entity](sp::ecs::Entity e) { return e == oe; } ), so.end());
+                    if (so.empty())
+                        small_entities.erase(it);
+                }
+                ao.grid_key = key;
+                small_entities[ao.grid_key].push_back(entity);
             }
             break;
         }
     }
 }
 
+void PathFindingSystem::querySmallEntities(glm::vec2 start, glm::vec2 end, float range, std::vector<sp::ecs::Entity>& result) const
+{
+    auto diff = end - start;
+    int y_min = std::floor((std::min(start.y, end.y) - range) / small_object_grid_size);
+    int y_max = std::floor((std::max(start.y, end.y) + range) / small_object_grid_size);
+    for(int y=y_min; y<=y_max; y++)
+    {
+        // Find the part of the line that comes within range of this row of cells.
+        float t0 = 0.0f;
+        float t1 = 1.0f;
+        if (diff.y != 0.0f)
+        {
+            float ta = (float(y) * small_object_grid_size - range - start.y) / diff.y;
+            float tb = (float(y + 1) * small_object_grid_size + range - start.y) / diff.y;
+            if (ta > tb)
+                std::swap(ta, tb);
+            t0 = std::max(t0, ta);
+            t1 = std::min(t1, tb);
+            if (t0 > t1)
+                continue;
+        }
+        float xa = start.x + diff.x * t0;
+        float xb = start.x + diff.x * t1;
+        int x_min = std::floor((std::min(xa, xb) - range) / small_object_grid_size);
+        int x_max = std::floor((std::max(xa, xb) + range) / small_object_grid_size);
+        for(int x=x_min; x<=x_max; x++)
+        {
+            auto it = small_entities.find(gridKey(x, y));
+            if (it != small_entities.end())
+                result.insert(result.end(), it->second.begin(), it->second.end());
+        }
+    }
+}
+
 
 PathPlanner::PathPlanner()
 {
@@ -160,7 +215,7 @@ bool PathPlanner::checkToAvoid(glm::vec2 start, glm::vec2 end, glm::vec2& new_po
     sp::ecs::Entity avoidObject;
     glm::vec2 firstAvoidQ{};
 
-    for(auto e : path_finding_system->big_entities)
+    auto check = [&](sp::ecs::Entity e)
     {
         auto ao = e.getComponent<AvoidObject>();
         auto transform = e.getComponent<sp::Transform>();
@@ -182,79 +237,15 @@ bool PathPlanner::checkToAvoid(glm::vec2 start, glm::vec2 end, glm::vec2& new_po
                 }
             }
         }
-    }
-
-    {
-        // Bresenham's line algorithm to
-        int x1 = std::floor(start.x / small_object_grid_size);
-        int y1 = std::floor(start.y / small_object_grid_size);
-        int x2 = std::floor(end.x / small_object_grid_size);
-        int y2 = std::floor(end.y / small_object_grid_size);
+    };
 
-        const bool steep = abs(y2 - y1) > abs(x2 - x1);
-        if(steep)
-        {
-            std::swap(x1, y1);
-            std::swap(x2, y2);
-        }
-
-        if(x1 > x2)
-        {
-            std::swap(x1, x2);
-            std::swap(y1, y2);
-        }
-
-        const int dx = x2 - x1;
-        const int dy = abs(y2 - y1);
-
-        int error = dx / 2;
-        const int ystep = (y1 < y2) ? 1 : -1;
-        int y = y1;
-
-        for(int x=x1; x<=x2; x++)
-        {
-            uint32_t hash;
-            if(steep)
-            {
-                hash = hashPosition({y * small_object_grid_size, x * small_object_grid_size});
-            }
-            else
-            {
-                hash = hashPosition({x * small_object_grid_size, y * small_object_grid_size});
-            }
-
-            for(auto e : path_finding_system->small_entities[hash])
-            {
-                auto ao = e.getComponent<AvoidObject>();
-                auto transform = e.getComponent<sp::Transform>();
-                if (ao && transform)
-                {
-                    glm::vec2 position = transform->getPosition();
-                    float f = glm::dot(startEndDiff, position - start) / startEndLength;
-                    if (f > 0 && f < startEndLength - ao->range)
-                    {
-                        glm::vec2 q = start + startEndDiff / startEndLength * f;
-                        if (glm::length2(q - position) < (ao->range + my_size) * (ao->range + my_size))
-                        {
-                            if (f < firstAvoidF)
-                            {
-                                avoidObject = e;
-                                firstAvoidF = f;
-                                firstAvoidQ = q;
-                            }
-                        }
-                    }
-                }
-            }
+    for(auto e : path_finding_system->big_entities)
+        check(e);
 
-            error -= dy;
-            if(error < 0)
-            {
-                y += ystep;
-                error += dx;
-            }
-        }
-    }
+    nearby_entities.clear();
+    path_finding_system->querySmallEntities(start, end, small_object_max_size + my_size, nearby_entities);
+    for(auto e : nearby_entities)
+        check(e);
 
     if (firstAvoidF < startEndLength)
     {
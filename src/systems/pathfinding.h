@@ -12,9 +12,13 @@ public:
     PathFindingSystem();
     void update(float delta) override;
 
+    // Add all small avoid objects in grid cells that come within range of the line from start to end to the result.
+    void querySmallEntities(glm::vec2 start, glm::vec2 end, float range, std::vector<sp::ecs::Entity>& result) const;
+
 private:
     std::vector<sp::ecs::Entity> big_entities;
-    std::unordered_map<uint32_t, std::vector<sp::ecs::Entity> > small_entities;
+    // Small objects by grid cell, see gridKey in pathfinding.cpp.
+    std::unordered_map<uint64_t, std::vector<sp::ecs::Entity> > small_entities;
 
     friend class PathPlanner;
 };
@@ -35,6 +39,8 @@ public:
     void plan(float my_radius, glm::vec2 start, glm::vec2 end);
     void clear();
 private:
+    std::vector<sp::ecs::Entity> nearby_entities;
+
     void recursivePlan(glm::vec2 start, glm::vec2 end, int& recursion_counter);
     bool checkToAvoid(glm::vec2 start, glm::vec2 end, glm::vec2& new_point, glm::vec2* alt_point=NULL);
 };
@@ -9,10 +9,15 @@ float RadarRenderSystem::current_scale;
 float RadarRenderSystem::current_rotation_offset;
 glm::vec2 RadarRenderSystem::radar_screen_center;
 glm::vec2 RadarRenderSystem::view_position;
-sp::Bitset RadarRenderSystem::visible_objects;
+const sp::Bitset* RadarRenderSystem::visible_objects;
 std::vector<RadarRenderSystem::Handler> RadarRenderSystem::handlers;
 
 
+BasicRadarRendering::BasicRadarRendering()
+{
+    unscanned_icon_index = getIconIndex("radar/ship.png");
+}
+
 void BasicRadarRendering::renderOnRadar(sp::RenderTarget& renderer, sp::ecs::Entity entity, glm::vec2 screen_position, float scale, float rotation, RadarTrace& trace)
 {
     if ((RadarRenderSystem::current_flags & RadarRenderSystem::FlagLongRange) && !(trace.flags & RadarTrace::LongRange))
@@ -22,6 +27,11 @@ void BasicRadarRendering::renderOnRadar(sp::RenderTarget& renderer, sp::ecs::Ent
     auto size = trace.radius * scale * 2.0f;
     size = std::clamp(size, trace.min_size, trace.max_size);
 
+    // Only look up the scan state once, it searches the entries of all factions.
+    auto scan_state = ScanState::State::FullScan;
+    if (scanstate && my_spaceship)
+        scan_state = scanstate->getStateFor(my_spaceship);
+
     auto color = trace.color;
     if (trace.flags & RadarTrace::ColorByFaction) {
         color = Faction::getInfo(entity).gm_color;
@@ -29,39 +39,90 @@ void BasicRadarRendering::renderOnRadar(sp::RenderTarget& renderer, sp::ecs::Ent
         {
             if (entity == my_spaceship)
                 color = glm::u8vec4(192, 192, 255, 255);
-            else if (scanstate && scanstate->getStateFor(my_spaceship) == ScanState::State::NotScanned)
+            else if (scan_state == ScanState::State::NotScanned)
                 color = glm::u8vec4(192, 192, 192, 255);
-            else if (Faction::getRelation(my_spaceship, entity) == FactionRelation::Enemy)
+            else switch(Faction::getRelation(my_spaceship, entity)) {
+            case FactionRelation::Enemy:
                 color = glm::u8vec4(255, 0, 0, 255);
-            else if (Faction::getRelation(my_spaceship, entity) == FactionRelation::Friendly)
+                break;
+            case FactionRelation::Friendly:
                 color = glm::u8vec4(128, 255, 128, 255);
-            else
+                break;
+            default:
                 color = glm::u8vec4(128, 128, 255, 255);
+                break;
+            }
         }
     }
-    auto icon = trace.icon;
+    // The index stays valid until the icon of the trace changes, so this is a single compare per contact instead of a search.
+    if (trace.icon_index >= icons.size() || icons[trace.icon_index] != trace.icon)
+        trace.icon_index = getIconIndex(trace.icon);
+    auto icon = trace.icon_index;
     if ((trace.flags & RadarTrace::ArrowIfNotScanned) && scanstate && my_spaceship)
     {
         // If the object is a ship that hasn't been scanned, draw the default icon.
         // Otherwise, draw the ship-specific icon.
-        switch(scanstate->getStateFor(my_spaceship)) {
+        switch(scan_state) {
         case ScanState::State::NotScanned:
         case ScanState::State::FriendOrFoeIdentified:
-            icon = "radar/ship.png";
+            icon = unscanned_icon_index;
             break;
         default:
             break;
         }
     }
 
-    if ((trace.flags & RadarTrace::BlendAdd) && (trace.flags & RadarTrace::Rotate))
-        renderer.drawRotatedSpriteBlendAdd(icon, screen_position, size, rotation);
-    else if (trace.flags & RadarTrace::BlendAdd)
-        renderer.drawRotatedSpriteBlendAdd(icon, screen_position, size, 0);
+    auto mode = SpriteMode::Plain;
+    if (trace.flags & RadarTrace::BlendAdd)
+        mode = SpriteMode::BlendAdd;
     else if (trace.flags & RadarTrace::Rotate)
-        renderer.drawRotatedSprite(icon, screen_position, size, rotation, color);
-    else
-        renderer.drawSprite(icon, screen_position, size, color);
+        mode = SpriteMode::Rotated;
+    if (!(trace.flags & RadarTrace::Rotate))
+        rotation = 0.0f;
+    sprites.push_back({uint16_t(icon * 3 + int(mode)), screen_position, size, rotation, color});
+}
+
+void BasicRadarRendering::renderOnRadarDone(sp::RenderTarget& renderer)
+{
+    if (sprites.empty())
+        return;
+
+    // Counting sort on the key, which keeps the original order of the contacts with the same icon.
+    key_offsets.assign(icons.size() * 3 + 1, 0);
+    for(auto& sprite : sprites)
+        key_offsets[sprite.key + 1]++;
+    for(size_t n=1; n<key_offsets.size(); n++)
+        key_offsets[n] += key_offsets[n - 1];
+    sorted_sprites.resize(sprites.size());
+    for(auto& sprite : sprites)
+        sorted_sprites[key_offsets[sprite.key]++] = sprite;
+    sprites.clear();
+
+    for(auto& sprite : sorted_sprites)
+    {
+        auto& icon = icons[sprite.key / 3];
+        switch(SpriteMode(sprite.key % 3))
+        {
+        case SpriteMode::Plain:
+            renderer.drawSprite(icon, sprite.position, sprite.size, sprite.color);
+            break;
+        case SpriteMode::Rotated:
+            renderer.drawRotatedSprite(icon, sprite.position, sprite.size, sprite.rotation, sprite.color);
+            break;
+        case SpriteMode::BlendAdd:
+            renderer.drawRotatedSpriteBlendAdd(icon, sprite.position, sprite.size, sprite.rotation);
+            break;
+        }
+    }
+}
+
+uint16_t BasicRadarRendering::getIconIndex(const string& icon)
+{
+    for(size_t n=0; n<icons.size(); n++)
+        if (icons[n] == icon)
+            return n;
+    icons.push_back(icon);
+    return icons.size() - 1;
 }
 
 void BasicRadarRendering::renderOnRadar(sp::RenderTarget& renderer, sp::ecs::Entity entity, glm::vec2 screen_position, float scale, float rotation, CallSign& callsign)
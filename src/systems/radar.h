@@ -6,12 +6,15 @@
 #include <vectorUtils.h>
 #include <graphics/renderTarget.h>
 #include "components/collision.h"
+#include "profiler.h"
 
 
 template<typename T, int PRIO, int FLAGS> class RenderRadarInterface {
 public:
     RenderRadarInterface();
     virtual void renderOnRadar(sp::RenderTarget& renderer, sp::ecs::Entity e, glm::vec2 screen_position, float scale, float rotation, T& component) = 0;
+    // Called after renderOnRadar was called for all visible entities, for handlers that collect what to draw first.
+    virtual void renderOnRadarDone(sp::RenderTarget& renderer) {}
 };
 
 class RadarRenderSystem {
@@ -21,12 +24,13 @@ public:
             PRIO, FLAGS, rrif, [](sp::RenderTarget& renderer, void* interface) {
                 auto rr = reinterpret_cast<RenderRadarInterface<T, PRIO, FLAGS>*>(interface);
                 for(auto [entity, component, transform] : sp::ecs::Query<T, sp::Transform>()) {
-                    if (!visible_objects.has(entity.getIndex())) continue;
+                    if (!visible_objects->has(entity.getIndex())) continue;
 
                     auto radar_position = rotateVec2((transform.getPosition() - view_position) * current_scale, current_rotation_offset);
                     radar_position += radar_screen_center;
                     rr->renderOnRadar(renderer, entity, radar_position, current_scale, transform.getRotation() + current_rotation_offset, component);
                 }
+                rr->renderOnRadarDone(renderer);
             }
         });
         std::sort(handlers.begin(), handlers.end(), [](const Handler& a, const Handler& b) {
@@ -34,18 +38,21 @@ public:
         });
     }
 
-    static void render(sp::RenderTarget& renderer, glm::vec2 _radar_screen_center, float scale, glm::vec2 _view_position, float view_rotation, int flags, sp::Bitset _visible_objects) {
+    static void render(sp::RenderTarget& renderer, glm::vec2 _radar_screen_center, float scale, glm::vec2 _view_position, float view_rotation, int flags, const sp::Bitset& _visible_objects) {
         radar_screen_center = _radar_screen_center;
         current_scale = scale;
         current_rotation_offset = -view_rotation;
         current_flags = flags;
         view_position = _view_position;
-        visible_objects = _visible_objects;
+        visible_objects = &_visible_objects;
 
+        static auto profiler_section = Profiler::getSection("render", "radar");
+        Profiler::Scope scope(profiler_section);
         for(auto& handler : handlers) {
             if ((handler.flags & flags) == handler.flags)
                 handler.func(renderer, handler.rrif);
         }
+        visible_objects = nullptr;
     }
 
     static constexpr int FlagNone = 0x00;
@@ -59,7 +66,7 @@ private:
     static float current_rotation_offset;
     static glm::vec2 radar_screen_center;
     static glm::vec2 view_position;
-    static sp::Bitset visible_objects;
+    static const sp::Bitset* visible_objects;
     struct Handler {
         int priority;
         int flags;
@@ -78,8 +85,30 @@ class BasicRadarRendering :
     public RenderRadarInterface<RadarTrace, 50, RadarRenderSystem::FlagNone>,
     public RenderRadarInterface<CallSign, 100, RadarRenderSystem::FlagNone> {
 public:
+    BasicRadarRendering();
     void update(float delta) override {}
 
     void renderOnRadar(sp::RenderTarget& renderer, sp::ecs::Entity e, glm::vec2 screen_position, float scale, float rotation, RadarTrace& component) override;
     void renderOnRadar(sp::RenderTarget& renderer, sp::ecs::Entity e, glm::vec2 screen_position, float scale, float rotation, CallSign& component) override;
+    void renderOnRadarDone(sp::RenderTarget& renderer) override;
+
+private:
+    // Radar traces are not drawn directly, but collected and then drawn grouped per icon and blend mode.
+    // The renderer then gets long runs of the same texture to batch, instead of switching between icons per contact.
+    enum class SpriteMode : uint8_t { Plain, Rotated, BlendAdd };
+    struct Sprite
+    {
+        uint16_t key; // icon index * 3 + mode, the order in which they are drawn.
+        glm::vec2 position;
+        float size;
+        float rotation;
+        glm::u8vec4 color;
+    };
+    std::vector<Sprite> sprites;
+    std::vector<Sprite> sorted_sprites;
+    std::vector<uint32_t> key_offsets;
+    std::vector<string> icons; // Every icon seen so far, RadarTrace::icon_index points in here.
+    uint16_t unscanned_icon_index;
+
+    uint16_t getIconIndex(const string& icon);
 };
@@ -3,7 +3,155 @@
 #include "components/collision.h"
 #include "ecs/query.h"
 #include <glm/gtx/norm.hpp>
+#include <limits>
 
+// Size of the broadphase grid cells. Matches the default nebula range, so a typical nebula covers 3x3 cells.
+const float radar_block_grid_size = 5000.0f;
+// Blocks that would be inserted in more cells then this are always checked instead.
+const int radar_block_max_cells = 64;
+static RadarBlockSystem* radar_block_system;
+
+
+static glm::ivec2 gridCell(glm::vec2 position)
+{
+    return {int(std::floor(position.x / radar_block_grid_size)), int(std::floor(position.y / radar_block_grid_size))};
+}
+
+static uint64_t gridKey(int x, int y)
+{
+    return (uint64_t(uint32_t(x)) << 32) | uint64_t(uint32_t(y));
+}
+
+RadarBlockSystem::RadarBlockSystem()
+{
+    radar_block_system = this;
+}
+
+void RadarBlockSystem::update(float delta)
+{
+    // Only rebuild the grid when a radar block was added, removed, moved or resized.
+    size_t index = 0;
+    bool changed = false;
+    for(auto [entity, block, transform] : sp::ecs::Query<RadarBlock, sp::Transform>())
+    {
+        if (index >= blocks.size()) {
+            changed = true;
+            break;
+        }
+        auto& b = blocks[index++];
+        if (b.entity != entity || b.position != transform.getPosition() || b.range != block.range || b.behind != block.behind) {
+            changed = true;
+            break;
+        }
+    }
+    if (changed || index != blocks.size())
+        rebuild();
+}
+
+void RadarBlockSystem::rebuild()
+{
+    blocks.clear();
+    large_blocks.clear();
+    for(auto& it : grid)
+        it.second.clear();
+
+    for(auto [entity, block, transform] : sp::ecs::Query<RadarBlock, sp::Transform>())
+    {
+        uint32_t index = blocks.size();
+        blocks.push_back({entity, transform.getPosition(), block.range, block.behind});
+
+        auto cmin = gridCell(transform.getPosition() - glm::vec2(block.range, block.range));
+        auto cmax = gridCell(transform.getPosition() + glm::vec2(block.range, block.range));
+        if ((cmax.x - cmin.x + 1) * (cmax.y - cmin.y + 1) > radar_block_max_cells) {
+            large_blocks.push_back(index);
+            continue;
+        }
+        for(int x=cmin.x; x<=cmax.x; x++)
+            for(int y=cmin.y; y<=cmax.y; y++)
+                grid[gridKey(x, y)].push_back(index);
+    }
+
+    // Drop cells that are no longer used, so the grid does not grow forever with moving blocks.
+    for(auto it = grid.begin(); it != grid.end(); )
+    {
+        if (it->second.empty())
+            it = grid.erase(it);
+        else
+            ++it;
+    }
+}
+
+bool RadarBlockSystem::sourceBlocked(glm::vec2 source) const
+{
+    auto check = [this, source](uint32_t index) {
+        auto& b = blocks[index];
+        return glm::length2(source - b.position) < b.range * b.range;
+    };
+    for(auto index : large_blocks)
+        if (check(index))
+            return true;
+    auto cell = gridCell(source);
+    auto it = grid.find(gridKey(cell.x, cell.y));
+    if (it != grid.end())
+        for(auto index : it->second)
+            if (check(index))
+                return true;
+    return false;
+}
+
+bool RadarBlockSystem::segmentBlocked(glm::vec2 source, glm::vec2 target) const
+{
+    auto startEndDiff = target - source;
+    float startEndLength = glm::length(startEndDiff);
+    auto check = [this, source, startEndDiff, startEndLength](uint32_t index) {
+        auto& b = blocks[index];
+        if (!b.behind)
+            return false;
+        //Calculate point q, which is a point on the line start-end that is closest to the block position
+        float f = glm::dot(startEndDiff, b.position - source) / startEndLength;
+        if (f < 0.0f)
+            f = 0.0f;
+        if (f > startEndLength)
+            f = startEndLength;
+        auto q = source + startEndDiff / startEndLength * f;
+        return glm::length2(q - b.position) < b.range * b.range;
+    };
+
+    for(auto index : large_blocks)
+        if (check(index))
+            return true;
+    if (grid.empty())
+        return false;
+
+    // Walk all grid cells the segment crosses (Amanatides & Woo). Blocks are in every cell their circle touches,
+    // so any block the segment passes through is found in one of these cells.
+    auto cell = gridCell(source);
+    auto end_cell = gridCell(target);
+    int steps = std::abs(end_cell.x - cell.x) + std::abs(end_cell.y - cell.y);
+    int step_x = startEndDiff.x > 0.0f ? 1 : -1;
+    int step_y = startEndDiff.y > 0.0f ? 1 : -1;
+    constexpr float inf = std::numeric_limits<float>::infinity();
+    float t_max_x = startEndDiff.x != 0.0f ? ((cell.x + (step_x > 0 ? 1 : 0)) * radar_block_grid_size - source.x) / startEndDiff.x : inf;
+    float t_max_y = startEndDiff.y != 0.0f ? ((cell.y + (step_y > 0 ? 1 : 0)) * radar_block_grid_size - source.y) / startEndDiff.y : inf;
+    float t_delta_x = startEndDiff.x != 0.0f ? radar_block_grid_size / std::abs(startEndDiff.x) : inf;
+    float t_delta_y = startEndDiff.y != 0.0f ? radar_block_grid_size / std::abs(startEndDiff.y) : inf;
+    for(int n=0; n<=steps; n++)
+    {
+        auto it = grid.find(gridKey(cell.x, cell.y));
+        if (it != grid.end())
+            for(auto index : it->second)
+                if (check(index))
+                    return true;
+        if (t_max_x < t_max_y) {
+            t_max_x += t_delta_x;
+            cell.x += step_x;
+        } else {
+            t_max_y += t_delta_y;
+            cell.y += step_y;
+        }
+    }
+    return false;
+}
 
 void RadarBlockSystem::renderOnRadar(sp::RenderTarget& renderer, sp::ecs::Entity e, glm::vec2 screen_position, float scale, float rotation, RadarBlock& component)
 {
@@ -12,6 +160,8 @@ void RadarBlockSystem::renderOnRadar(sp::RenderTarget& renderer, sp::ecs::Entity
 
 bool RadarBlockSystem::inRadarBlock(glm::vec2 position)
 {
+    if (radar_block_system)
+        return radar_block_system->sourceBlocked(position);
     for(auto [entity, block, transform] : sp::ecs::Query<RadarBlock, sp::Transform>())
     {
         if (glm::length2(position - transform.getPosition()) < block.range*block.range)
@@ -31,6 +181,9 @@ bool RadarBlockSystem::isRadarBlockedFrom(glm::vec2 source, sp::ecs::Entity enti
     if (startEndLength < short_range)
         return false;
 
+    if (radar_block_system)
+        return radar_block_system->sourceBlocked(source) || radar_block_system->segmentBlocked(source, et->getPosition());
+
     for(auto [entity, block, transform] : sp::ecs::Query<RadarBlock, sp::Transform>())
     {
         if (block.behind) {
@@ -50,3 +203,29 @@ bool RadarBlockSystem::isRadarBlockedFrom(glm::vec2 source, sp::ecs::Entity enti
     }
     return false;
 }
+
+bool RadarBlockSystem::isPositionBlockedFrom(glm::vec2 source, glm::vec2 target, float short_range)
+{
+    if (!radar_block_system || glm::length2(target - source) < short_range * short_range)
+        return false;
+    return radar_block_system->sourceBlocked(source) || radar_block_system->segmentBlocked(source, target);
+}
+
+void RadarBlockSystem::getVisibleFrom(glm::vec2 source, float short_range, sp::Bitset& visible_objects)
+{
+    // When the source itself is inside a radar block, only the short range is visible, so that test is done once for all targets.
+    bool source_blocked = radar_block_system ? radar_block_system->sourceBlocked(source) : false;
+    for(auto [entity, transform] : sp::ecs::Query<sp::Transform>())
+    {
+        if (!radar_block_system) {
+            if (!isRadarBlockedFrom(source, entity, short_range))
+                visible_objects.set(entity.getIndex());
+            continue;
+        }
+        if (!entity.hasComponent<NeverRadarBlocked>() && glm::length2(transform.getPosition() - source) >= short_range * short_range) {
+            if (source_blocked || radar_block_system->segmentBlocked(source, transform.getPosition()))
+                continue;
+        }
+        visible_objects.set(entity.getIndex());
+    }
+}
@@ -2,6 +2,9 @@
 
 #include <glm/vec2.hpp>
 #include <ecs/entity.h>
+#include <container/bitset.h>
+#include <unordered_map>
+#include <vector>
 #include "components/radarblock.h"
 #include "systems/radar.h"
 
@@ -9,9 +12,32 @@
 class RadarBlockSystem : public sp::ecs::System, public RenderRadarInterface<RadarBlock, 11, RadarRenderSystem::FlagGM>
 {
 public:
-    void update(float delta) override {}
+    RadarBlockSystem();
+    void update(float delta) override;
 
     void renderOnRadar(sp::RenderTarget& renderer, sp::ecs::Entity e, glm::vec2 screen_position, float scale, float rotation, RadarBlock& component) override;
     static bool inRadarBlock(glm::vec2 position);
     static bool isRadarBlockedFrom(glm::vec2 source, sp::ecs::Entity entity, float short_range);
-};
\ No newline at end of file
+    // Same test for a position, ignoring NeverRadarBlocked. Only uses the snapshot taken at update time, not the components,
+    // so it is safe to call from multiple threads while the main thread waits. Nothing is blocked before the system exists.
+    static bool isPositionBlockedFrom(glm::vec2 source, glm::vec2 target, float short_range);
+    // Batch version of isRadarBlockedFrom, sets the bit of every entity with a transform that is not radar blocked from the source.
+    static void getVisibleFrom(glm::vec2 source, float short_range, sp::Bitset& visible_objects);
+
+private:
+    // Snapshot of a RadarBlock, taken at update time, so queries do not need to touch the components.
+    struct Block {
+        sp::ecs::Entity entity;
+        glm::vec2 position;
+        float range;
+        bool behind;
+    };
+
+    void rebuild();
+    bool sourceBlocked(glm::vec2 source) const;
+    bool segmentBlocked(glm::vec2 source, glm::vec2 target) const;
+
+    std::vector<Block> blocks;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> grid; // cell key -> index in blocks
+    std::vector<uint32_t> large_blocks; // Blocks covering too many cells to be put in the grid.
+};
@@ -1,6 +1,8 @@
 #include "systems/rendering.h"
 #include "components/rendering.h"
 #include "textureManager.h"
+#include "assetLoader.h"
+#include "profiler.h"
 #include "vectorUtils.h"
 #include "shaderRegistry.h"
 #include <graphics/opengl.h>
@@ -20,9 +22,15 @@ void RenderSystem::render3D(float aspect, float camera_fov)
         depth_cutoff_front = std::numeric_limits<float>::infinity();
     if (camera_pitch + camera_fov/2.f >= 180.f)
         depth_cutoff_back = -std::numeric_limits<float>::infinity();
-    for(auto& handler : render_handlers)
-        (this->*(handler.func))(handler.rif);
+    static auto profiler_cull = Profiler::getSection("render", "render3d_cull");
+    static auto profiler_draw = Profiler::getSection("render", "render3d_draw");
+    {
+        Profiler::Scope scope(profiler_cull);
+        for(auto& handler : render_handlers)
+            (this->*(handler.func))(handler.rif);
+    }
 
+    Profiler::Scope scope(profiler_draw);
     for(int n=render_lists.size() - 1; n >= 0; n--)
     {
         auto& render_list = render_lists[n];
@@ -124,6 +132,10 @@ void MeshRenderSystem::update(float delta)
 
 void MeshRenderSystem::render3D(sp::ecs::Entity e, sp::Transform& transform, MeshRenderComponent& mrc)
 {
+    // Not drawn until the mesh has finished loading.
+    if (!mrc.getMesh())
+        return;
+
     auto model_matrix = calculateModelMatrix(
             transform.getPosition(),
             transform.getRotation(),
@@ -187,9 +199,10 @@ void NebulaRenderSystem::render3D(sp::ecs::Entity e, sp::Transform& transform, N
         }
 
         if (!cloud.texture.ptr)
-            cloud.texture.ptr = textureManager.getTexture(cloud.texture.name);
-        if (cloud.texture.ptr)
-            cloud.texture.ptr->bind();
+            cloud.texture.ptr = AssetLoader::getTexture(cloud.texture.name);
+        if (!cloud.texture.ptr)
+            continue;
+        cloud.texture.ptr->bind();
         glUniform4f(shader.get().uniform(ShaderRegistry::Uniforms::Color), alpha * 0.8f, alpha * 0.8f, alpha * 0.8f, size);
         auto cloud_model_matrix = glm::translate(glm::identity<glm::mat4>(), {cloud.offset.x, cloud.offset.y, 0});
         glUniformMatrix4fv(shader.get().uniform(ShaderRegistry::Uniforms::Model), 1, GL_FALSE, glm::value_ptr(cloud_model_matrix));
@@ -0,0 +1,194 @@
+// Headless simulation benchmark, built as the EmptyEpsilonBench target.
+// Runs a scenario for a fixed number of ticks and reports where the time went.
+// Preferences (given on the command line like any other):
+//   bench_scenario  Scenario to run, default benchmark_battle.lua.
+//   bench_ticks     Ticks to measure, default 3600.
+//   bench_warmup    Ticks to run before measuring, default 60.
+//   bench_seed      Seed for the script random() and irandom() functions, default 1.
+//   headless_tick_rate and headless_time_warp default to 60 and 1000, so ticks run back to back, see SimulationClock.
+//   bench_output    File to also write the report to.
+//   bench_selfcheck Set to 1 to run the self checks from selfCheck.cpp instead of a scenario.
+#include "benchmark.h"
+#include "profiler.h"
+#include "preferenceManager.h"
+#include "Updatable.h"
+#include "engine.h"
+#include "ecs/query.h"
+#include "components/collision.h"
+#include "components/ai.h"
+#include "multiplayer/interest.h"
+#include "script/scriptRandom.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+
+// Count every allocation made through the global operator new. This file is only linked into the benchmark.
+static std::atomic<uint64_t> allocation_count{0};
+
+void* operator new(size_t size)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+uint64_t getAllocationCount()
+{
+    return allocation_count.load();
+}
+
+
+class BenchmarkRunner : public Updatable
+{
+public:
+    BenchmarkRunner()
+    {
+        warmup_ticks = std::max(0, PreferencesManager::get("bench_warmup", "60").toInt());
+        measure_ticks = std::max(1, PreferencesManager::get("bench_ticks", "3600").toInt());
+    }
+
+    virtual void update(float delta) override
+    {
+        if (tick == warmup_ticks)
+            start();
+        tick++;
+        if (tick == warmup_ticks + measure_ticks)
+        {
+            finish();
+            engine->shutdown();
+        }
+    }
+
+private:
+    struct SectionStart
+    {
+        uint64_t count;
+        double total;
+    };
+
+    void start()
+    {
+        section_start.clear();
+        for(auto& section : Profiler::getSections())
+            section_start.push_back({section->count, section->total});
+        allocations_start = allocation_count.load();
+        bytes_start = ReplicationInterest::getTotalBytes();
+        simulated_start = engine->getElapsedTime();
+        wall_start = std::chrono::steady_clock::now();
+    }
+
+    void finish()
+    {
+        float wall_time = std::chrono::duration<float>(std::chrono::steady_clock::now() - wall_start).count();
+        float simulated_time = engine->getElapsedTime() - simulated_start;
+        auto allocations = allocation_count.load() - allocations_start;
+        auto bytes = ReplicationInterest::getTotalBytes() - bytes_start;
+
+        int entities = 0, ai = 0, physics = 0;
+        for(auto [entity, transform] : sp::ecs::Query<sp::Transform>())
+            entities++;
+        for(auto [entity, controller] : sp::ecs::Query<AIController>())
+            ai++;
+        for(auto [entity, p] : sp::ecs::Query<sp::Physics>())
+            physics++;
+
+        struct Row { const Profiler::Section* section; double total; uint64_t count; };
+        std::vector<Row> rows;
+        double busy = 0.0;
+        auto& sections = Profiler::getSections();
+        for(size_t n=0; n<sections.size(); n++)
+        {
+            auto& section = *sections[n];
+            SectionStart begin = n < section_start.size() ? section_start[n] : SectionStart{0, 0.0};
+            Row row{&section, section.total - begin.total, section.count - begin.count};
+            if (row.count == 0)
+                continue;
+            // Systems, scripts and replication do not nest, so together they are the time a tick was busy.
+            if (section.group != "render")
+                busy += row.total;
+            rows.push_back(row);
+        }
+        std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) { return a.total > b.total; });
+
+        string report;
+        report += "Scenario: " + PreferencesManager::get("headless") + ", seed " + PreferencesManager::get("bench_seed", "1") + "\n";
+        report += "Ticks: " + string(measure_ticks) + ", simulated " + string(simulated_time, 2) + "s in " + string(wall_time, 2) + "s wall time\n";
+        report += "Busy: " + string(float(busy / measure_ticks * 1000.0), 4) + " ms per tick\n";
+        report += "Entities: " + string(entities) + ", with AI " + string(ai) + ", with physics " + string(physics) + "\n";
+        report += "Allocations: " + string(std::to_string(allocations)) + ", " + string(float(allocations) / measure_ticks, 1) + " per tick\n";
+        report += "Replication: " + string(std::to_string(bytes)) + " bytes, " + string(float(bytes) / measure_ticks, 1) + " per tick\n";
+        report += "Section: ms per tick, calls per tick, p50 ms, p99 ms\n";
+        for(auto& row : rows)
+        {
+            auto p = Profiler::getPercentiles(*row.section);
+            report += "  " + row.section->group + " " + row.section->name + ": "
+                + string(float(row.total / measure_ticks * 1000.0), 4) + ", "
+                + string(float(row.count) / measure_ticks, 2) + ", "
+                + string(p.p50 * 1000.0f, 4) + ", "
+                + string(p.p99 * 1000.0f, 4) + "\n";
+        }
+
+        printf("%s", report.c_str());
+        fflush(stdout);
+        auto output = PreferencesManager::get("bench_output");
+        if (!output.empty())
+        {
+            if (FILE* f = fopen(output.c_str(), "wt"))
+            {
+                fputs(report.c_str(), f);
+                fclose(f);
+            }
+            else
+            {
+                LOG(ERROR) << "Could not write benchmark report to " << output;
+            }
+        }
+    }
+
+    int warmup_ticks;
+    int measure_ticks;
+    int tick = 0;
+
+    std::vector<SectionStart> section_start;
+    uint64_t allocations_start = 0;
+    uint64_t bytes_start = 0;
+    float simulated_start = 0.0f;
+    std::chrono::steady_clock::time_point wall_start;
+};
+
+void setupBenchmark()
+{
+    // Reuse the headless server startup, nobody needs to connect to it.
+    bool self_check = PreferencesManager::get("bench_selfcheck") == "1";
+    if (self_check)
+        PreferencesManager::set("headless", "scenario_10_empty.lua");
+    else
+        PreferencesManager::set("headless", PreferencesManager::get("bench_scenario", "benchmark_battle.lua"));
+    PreferencesManager::set("headless_internet", "0");
+    PreferencesManager::set("startpaused", "0");
+    if (PreferencesManager::get("headless_tick_rate").empty())
+        PreferencesManager::set("headless_tick_rate", "60");
+    if (PreferencesManager::get("headless_time_warp").empty())
+        PreferencesManager::set("headless_time_warp", "1000");
+    seedScriptRandom(PreferencesManager::get("bench_seed", "1").toInt());
+    if (self_check)
+        setupSelfCheck();
+    else
+        new BenchmarkRunner();
+}
@@ -0,0 +1,14 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <cstdint>
+
+// Only part of the EmptyEpsilonBench target, which builds main.cpp with EE_BENCHMARK defined.
+// Switches the startup to a headless run of a benchmark scenario, see benchmark.cpp for the preferences.
+void setupBenchmark();
+// Runs the checks from selfCheck.cpp on an empty scenario instead, when bench_selfcheck=1.
+void setupSelfCheck();
+// Allocations made through the global operator new since the start.
+uint64_t getAllocationCount();
+
+#endif//BENCHMARK_H
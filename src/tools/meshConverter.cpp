@@ -0,0 +1,54 @@
+#include <cstdio>
+#include "meshData.h"
+
+// Converts .obj and .model files into preprocessed .mesh files.
+// Mesh::getMesh loads "<name>.mesh" instead of parsing "<name>" when it is found next to it and matches the source.
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "Usage: %s <resource directory> <mesh file> [<mesh file>...]\n", argv[0]);
+        fprintf(stderr, "Writes <resource directory>/<mesh file>.mesh for each mesh file.\n");
+        return 1;
+    }
+
+    string directory = argv[1];
+    new DirectoryResourceProvider(directory);
+
+    int result = 0;
+    for(int n=2; n<argc; n++)
+    {
+        string filename = argv[n];
+        P<ResourceStream> stream = getResourceStream(filename);
+        if (!stream)
+        {
+            fprintf(stderr, "%s: not found\n", filename.c_str());
+            result = 1;
+            continue;
+        }
+        auto source_key = MeshData::sourceKey(stream);
+        auto data = MeshData::build(MeshData::parseSource(stream, filename));
+        if (data.vertices.empty())
+        {
+            fprintf(stderr, "%s: failed to load\n", filename.c_str());
+            result = 1;
+            continue;
+        }
+
+        auto buffer = data.writeBinary(source_key);
+        auto output = directory + "/" + filename + ".mesh";
+        FILE* f = fopen(output.c_str(), "wb");
+        if (!f || fwrite(buffer.data(), 1, buffer.size(), f) != buffer.size())
+        {
+            fprintf(stderr, "%s: failed to write\n", output.c_str());
+            result = 1;
+        }
+        else
+        {
+            printf("%s: %d vertices, %d indices\n", output.c_str(), int(data.vertices.size()), int(data.indices.size()));
+        }
+        if (f)
+            fclose(f);
+    }
+    return result;
+}
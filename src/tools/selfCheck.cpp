@@ -0,0 +1,1068 @@
+// Self checks, built into the EmptyEpsilonBench target and run with bench_selfcheck=1.
+// They cover code whose mistakes are hard to see from inside the game, like the replication wire format and
+// the bytes the hardware outputs put on the wire. Prints a line per check, and exits with a non zero code when
+// any of them failed, so it can be used from a script.
+#include "benchmark.h"
+#include "Updatable.h"
+#include "engine.h"
+#include "multiplayer/interest.h"
+#include "multiplayer/reactor.h"
+#include "multiplayer/beamweapon.h"
+#include "multiplayer/shields.h"
+#include "components/reactor.h"
+#include "components/beamweapon.h"
+#include "components/shields.h"
+#include "components/missiletubes.h"
+#include "components/impulse.h"
+#include "components/maneuveringthrusters.h"
+#include "components/jumpdrive.h"
+#include "components/warpdrive.h"
+#include "components/faction.h"
+#include "components/avoidobject.h"
+#include "components/collision.h"
+#include "systems/pathfinding.h"
+#include "glm/gtx/norm.hpp"
+#include "mesh.h"
+#include "meshData.h"
+#include "multiplayer.h"
+#include "random.h"
+#include "hardware/devices/sACNDMXDevice.h"
+#include "hardware/devices/philipsHueDevice.h"
+#include "hardware/serialDriver.h"
+#include "hardware/serialFrameScheduler.h"
+#include <io/network/udpSocket.h>
+#include <io/http/server.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#ifdef __gnu_linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+static int failures = 0;
+
+static void expect(bool condition, const string& message)
+{
+    if (condition)
+        return;
+    failures++;
+    printf("  failed: %s\n", message.c_str());
+}
+
+class SelfCheck
+{
+public:
+    virtual ~SelfCheck() = default;
+    // Called once per tick, with the tick counting from 0, until it returns true.
+    virtual bool run(int tick) = 0;
+};
+
+// Changes part of a set of ship components every tick and runs them through the update path of their
+// replication classes. Once the buffers had the chance to grow during the warmup, no tick may allocate anymore.
+class ReplicationAllocationCheck : public SelfCheck
+{
+public:
+    static constexpr int entity_count = 64;
+    static constexpr int warmup_ticks = 10;
+    static constexpr int measure_ticks = 300;
+
+    ReplicationAllocationCheck()
+    {
+        ReplicationInterest::forceClients(true);
+        for(int n=0; n<entity_count; n++)
+        {
+            auto entity = sp::ecs::Entity::create();
+            entity.addComponent<Reactor>();
+            entity.addComponent<BeamWeaponSys>().mounts.resize(4);
+            entity.addComponent<Shields>().entries.resize(2);
+            entities.push_back(entity);
+        }
+    }
+
+    ~ReplicationAllocationCheck()
+    {
+        ReplicationInterest::forceClients(false);
+        for(auto entity : entities)
+            entity.destroy();
+    }
+
+    virtual bool run(int tick) override
+    {
+        // Only a quarter of the entities changes per tick, the rest has to take the unchanged path.
+        for(size_t n=tick % 4; n<entities.size(); n+=4)
+        {
+            entities[n].getComponent<Reactor>()->energy = float(tick);
+            entities[n].getComponent<BeamWeaponSys>()->mounts[n % 4].cooldown = float(tick);
+            entities[n].getComponent<Shields>()->entries[n % 2].level = float(tick % 100) / 100.0f;
+        }
+
+        packet.clear();
+        // Only the updates are counted, the engine allocates in between ticks for its own reasons.
+        auto allocations_before = getAllocationCount();
+        for(auto replication : replications)
+            replication->update(packet);
+        auto allocations_after = getAllocationCount();
+        if (tick >= warmup_ticks)
+            allocations += allocations_after - allocations_before;
+
+        if (tick < warmup_ticks + measure_ticks - 1)
+            return false;
+        expect(packet.getDataSize() > 0, "nothing was replicated");
+        expect(allocations == 0, string(std::to_string(allocations)) + " allocations in " + string(measure_ticks) + " ticks");
+        return true;
+    }
+
+private:
+    std::vector<sp::ecs::Entity> entities;
+    ReactorReplication reactor;
+    BeamWeaponSysReplication beam_weapons;
+    ShieldsReplication shields;
+    sp::ecs::ComponentReplicationBase* replications[3] = {&reactor, &beam_weapons, &shields};
+    sp::io::DataBuffer packet;
+    uint64_t allocations = 0;
+};
+
+template<typename QUANTIZER> static void checkQuantizer(const char* name, float min, float max, float step)
+{
+    // Half a step of rounding, plus float precision of the decoded value.
+    float tolerance = step * 0.5f + std::max(std::abs(min), std::abs(max)) * 1e-6f;
+    for(int n=0; n<=1000; n++)
+    {
+        float value = min + (max - min) * n / 1000.0f;
+        float result = QUANTIZER::decode(QUANTIZER::encode(value, min, max), min, max);
+        if (std::abs(result - value) > tolerance)
+        {
+            expect(false, string(name) + ": " + string(value, 5) + " came back as " + string(result, 5));
+            return;
+        }
+    }
+    expect(QUANTIZER::decode(QUANTIZER::encode(min - 1.0f, min, max), min, max) == min, string(name) + ": below range is not clamped");
+    expect(QUANTIZER::decode(QUANTIZER::encode(max + 1.0f, min, max), min, max) == max, string(name) + ": above range is not clamped");
+    expect(QUANTIZER::decode(QUANTIZER::encode(min, min, max), min, max) == min, string(name) + ": minimum is not exact");
+    expect(QUANTIZER::decode(QUANTIZER::encode(max, min, max), min, max) == max, string(name) + ": maximum is not exact");
+    if (min < 0.0f && max > 0.0f)
+        expect(QUANTIZER::decode(QUANTIZER::encode(0.0f, min, max), min, max) == 0.0f, string(name) + ": zero is not exact");
+}
+
+// Round trips of the varint and the quantized encodings, for the ranges that the replication classes use.
+class WireEncodingCheck : public SelfCheck
+{
+public:
+    virtual bool run(int tick) override
+    {
+        sp::io::DataBuffer packet;
+        uint64_t values[] = {0, 1, 127, 128, 255, 16383, 16384, 0xffffffffULL, 0x100000000ULL, 0xffffffffffffffffULL};
+        for(auto value : values)
+            packet << ReplicationVarInt{value};
+        expect(packet.getDataSize() == 1 + 1 + 1 + 2 + 2 + 2 + 3 + 5 + 5 + 10, "varint size is " + string(int(packet.getDataSize())));
+        for(auto value : values)
+        {
+            auto result = ReplicationVarInt::read(packet);
+            expect(result == value, "varint " + string(std::to_string(value)) + " came back as " + string(std::to_string(result)));
+        }
+
+        using Q16 = ReplicationQuantizer<16>;
+        checkQuantizer<Q16>("health", -1.0f, 1.0f, 2.0f / 65535.0f);
+        checkQuantizer<Q16>("power", 0.0f, 3.0f, 3.0f / 65535.0f);
+        checkQuantizer<Q16>("heat", 0.0f, 1.0f, 1.0f / 65535.0f);
+        checkQuantizer<Q16>("coolant", 0.0f, 100.0f, 100.0f / 65535.0f);
+        checkQuantizer<ReplicationQuantizer<8>>("8 bits", 0.0f, 1.0f, 1.0f / 255.0f);
+
+        using A16 = ReplicationAngleQuantizer<16>;
+        float angle_tolerance = 360.0f / 65536.0f * 0.5f + 1e-4f;
+        for(int n=0; n<3600; n++)
+        {
+            float angle = n * 0.1f;
+            float result = A16::decode(A16::encode(angle, 0.0f, 360.0f), 0.0f, 360.0f);
+            float error = std::abs(std::fmod(result - angle + 540.0f, 360.0f) - 180.0f);
+            if (error > angle_tolerance)
+            {
+                expect(false, "angle " + string(angle, 2) + " came back as " + string(result, 4));
+                break;
+            }
+        }
+        expect(A16::decode(A16::encode(-90.0f, 0.0f, 360.0f), 0.0f, 360.0f) == 270.0f, "angle -90 does not wrap to 270");
+        expect(A16::decode(A16::encode(720.0f, 0.0f, 360.0f), 0.0f, 360.0f) == 0.0f, "angle 720 does not wrap to 0");
+        expect(A16::decode(A16::encode(359.999f, 0.0f, 360.0f), 0.0f, 360.0f) == 0.0f, "angle 359.999 does not wrap to 0");
+        return true;
+    }
+};
+
+// The reactor as it was replicated before quantization, every field as a full float.
+BASIC_REPLICATION_CLASS(UnquantizedReactorReplication, Reactor);
+BASIC_REPLICATION_IMPL(UnquantizedReactorReplication, Reactor)
+    BASIC_REPLICATION_FIELD(health);
+    BASIC_REPLICATION_FIELD(health_max);
+    BASIC_REPLICATION_FIELD(power_level);
+    BASIC_REPLICATION_FIELD(power_request);
+    BASIC_REPLICATION_FIELD(heat_level);
+    BASIC_REPLICATION_FIELD(coolant_level);
+    BASIC_REPLICATION_FIELD(coolant_request);
+    BASIC_REPLICATION_FIELD(can_be_hacked);
+    BASIC_REPLICATION_FIELD(hacked_level);
+    BASIC_REPLICATION_FIELD(power_factor);
+    BASIC_REPLICATION_FIELD(coolant_change_rate_per_second);
+    BASIC_REPLICATION_FIELD(heat_add_rate_per_second);
+    BASIC_REPLICATION_FIELD(power_change_rate_per_second);
+    BASIC_REPLICATION_FIELD(auto_repair_per_second);
+    BASIC_REPLICATION_FIELD(damage_per_second_on_overheat);
+    BASIC_REPLICATION_FIELD(max_energy);
+    BASIC_REPLICATION_FIELD(energy);
+}
+
+// Bytes of the real reactor replication next to the unquantized version above, for the first full
+// update of a ship and for an update where the system levels change, as they do during combat.
+// Both use the varint flags, before those the flags word took 8 bytes on its own.
+class PacketSizeCheck : public SelfCheck
+{
+public:
+    static constexpr int ship_count = 16;
+
+    PacketSizeCheck()
+    {
+        ReplicationInterest::forceClients(true);
+        for(int n=0; n<ship_count; n++)
+        {
+            auto entity = sp::ecs::Entity::create();
+            entity.addComponent<Reactor>();
+            entities.push_back(entity);
+        }
+    }
+
+    ~PacketSizeCheck()
+    {
+        ReplicationInterest::forceClients(false);
+        for(auto entity : entities)
+            entity.destroy();
+    }
+
+    virtual bool run(int tick) override
+    {
+        if (tick == 1)
+        {
+            for(auto entity : entities)
+            {
+                auto reactor = entity.getComponent<Reactor>();
+                reactor->health = 0.73f;
+                reactor->heat_level = 0.41f;
+                reactor->coolant_level = 2.5f;
+                reactor->power_level = 1.3f;
+            }
+        }
+
+        // Nothing else changes, so from tick 1 on both classes send the system levels exactly once.
+        packet.clear();
+        quantized.update(packet);
+        (tick == 0 ? full_size : update_size) += packet.getDataSize();
+        packet.clear();
+        unquantized.update(packet);
+        (tick == 0 ? unquantized_full_size : unquantized_update_size) += packet.getDataSize();
+
+        if (tick < 5)
+            return false;
+        printf("  full update: %d bytes per ship, %d unquantized\n", int(full_size / ship_count), int(unquantized_full_size / ship_count));
+        printf("  system levels: %d bytes per ship, %d unquantized\n", int(update_size / ship_count), int(unquantized_update_size / ship_count));
+        expect(full_size > 0 && update_size > 0, "nothing was replicated");
+        expect(full_size < unquantized_full_size, "quantized full update is not smaller");
+        expect(update_size < unquantized_update_size, "quantized system level update is not smaller");
+        return true;
+    }
+
+private:
+    std::vector<sp::ecs::Entity> entities;
+    ReactorReplication quantized_replication;
+    UnquantizedReactorReplication unquantized_replication;
+    sp::ecs::ComponentReplicationBase& quantized = quantized_replication;
+    sp::ecs::ComponentReplicationBase& unquantized = unquantized_replication;
+    sp::io::DataBuffer packet;
+    size_t full_size = 0, update_size = 0;
+    size_t unquantized_full_size = 0, unquantized_update_size = 0;
+};
+
+// ShipSystem::getAll has to give the same systems as ShipSystem::get, and is timed against looking up each
+// system on its own, which is what the energy and coolant systems did per ship per tick before.
+// The table is not cached between calls, components move in memory when any entity gains or loses one.
+class ShipSystemTableCheck : public SelfCheck
+{
+public:
+    static constexpr int ship_count = 64;
+    static constexpr int rounds = 1000;
+
+    ShipSystemTableCheck()
+    {
+        for(int n=0; n<ship_count; n++)
+        {
+            auto entity = sp::ecs::Entity::create();
+            // Leave some systems out, so the missing ones are covered as well.
+            entity.addComponent<Reactor>();
+            entity.addComponent<ImpulseEngine>();
+            entity.addComponent<ManeuveringThrusters>();
+            if (n % 2) entity.addComponent<BeamWeaponSys>();
+            if (n % 3) entity.addComponent<MissileTubes>();
+            if (n % 4) entity.addComponent<WarpDrive>();
+            if (n % 5) entity.addComponent<JumpDrive>();
+            if (n % 6) entity.addComponent<Shields>().entries.resize(n % 3);
+            entities.push_back(entity);
+        }
+    }
+
+    ~ShipSystemTableCheck()
+    {
+        for(auto entity : entities)
+            entity.destroy();
+    }
+
+    virtual bool run(int tick) override
+    {
+        for(auto entity : entities)
+        {
+            auto table = ShipSystem::getAll(entity);
+            for(int n=0; n<ShipSystem::COUNT; n++)
+                expect(table[n] == ShipSystem::get(entity, ShipSystem::Type(n)), "table differs for " + getSystemName(ShipSystem::Type(n)));
+        }
+
+        // Sum the levels, so the lookups cannot be optimized away.
+        float sum = 0.0f;
+        auto start = std::chrono::steady_clock::now();
+        for(int round=0; round<rounds; round++)
+            for(auto entity : entities)
+                for(auto system : ShipSystem::getAll(entity))
+                    if (system) sum += system->power_level;
+        auto table_time = std::chrono::steady_clock::now() - start;
+        start = std::chrono::steady_clock::now();
+        for(int round=0; round<rounds; round++)
+            for(auto entity : entities)
+                for(int n=0; n<ShipSystem::COUNT; n++)
+                    if (auto system = ShipSystem::get(entity, ShipSystem::Type(n))) sum += system->power_level;
+        auto get_time = std::chrono::steady_clock::now() - start;
+
+        auto per_ship = [](auto time) { return float(std::chrono::duration<double, std::nano>(time).count() / (rounds * ship_count)); };
+        printf("  getAll: %s ns per ship, get per system: %s ns per ship (%s)\n", string(per_ship(table_time), 1).c_str(), string(per_ship(get_time), 1).c_str(), string(sum, 0).c_str());
+        return true;
+    }
+
+private:
+    std::vector<sp::ecs::Entity> entities;
+};
+
+// Faction::getRelation has to give the same relation as the linear search through FactionInfo::relations that
+// it replaced, for pairs of ships of all factions, including ships without a faction and relations towards no faction.
+// Both are timed over the same pairs.
+class FactionRelationCheck : public SelfCheck
+{
+public:
+    static constexpr int faction_count = 12;
+    static constexpr int ship_count = 200;
+    static constexpr int pair_count = 10000;
+    static constexpr int rounds = 10;
+
+    FactionRelationCheck()
+    {
+        for(int n=0; n<faction_count; n++)
+        {
+            auto entity = sp::ecs::Entity::create();
+            entity.addComponent<FactionInfo>().name = "SelfCheck" + string(n);
+            factions.push_back(entity);
+        }
+        for(auto faction : factions)
+        {
+            auto& info = *faction.getComponent<FactionInfo>();
+            for(auto other : factions)
+                if (irandom(0, 2) > 0)
+                    info.setRelation(other, FactionRelation(irandom(0, 2)));
+            if (irandom(0, 1))
+                info.setRelation({}, FactionRelation(irandom(0, 2)));
+            // A second entry for the same faction, the first one has to win.
+            info.relations.push_back({factions[irandom(0, faction_count - 1)], FactionRelation(irandom(0, 2))});
+        }
+        Faction::invalidateRelationMatrix();
+
+        for(int n=0; n<ship_count; n++)
+        {
+            auto entity = sp::ecs::Entity::create();
+            // Every tenth ship has no faction.
+            if (n % 10)
+                entity.addComponent<Faction>().entity = factions[irandom(0, faction_count - 1)];
+            ships.push_back(entity);
+        }
+        for(int n=0; n<pair_count; n++)
+            pairs.push_back({ships[irandom(0, ship_count - 1)], ships[irandom(0, ship_count - 1)]});
+    }
+
+    ~FactionRelationCheck()
+    {
+        for(auto entity : ships)
+            entity.destroy();
+        for(auto entity : factions)
+            entity.destroy();
+        Faction::invalidateRelationMatrix();
+    }
+
+    virtual bool run(int tick) override
+    {
+        int mismatches = 0;
+        for(auto& [a, b] : pairs)
+            if (linearRelation(a, b) != Faction::getRelation(a, b))
+                mismatches++;
+        expect(mismatches == 0, string(mismatches) + " of " + string(pair_count) + " pairs have a different relation");
+
+        // Count the enemies, so the lookups cannot be optimized away.
+        int enemies = 0;
+        auto start = std::chrono::steady_clock::now();
+        for(int round=0; round<rounds; round++)
+            for(auto& [a, b] : pairs)
+                enemies += linearRelation(a, b) == FactionRelation::Enemy;
+        auto linear_time = std::chrono::steady_clock::now() - start;
+        start = std::chrono::steady_clock::now();
+        for(int round=0; round<rounds; round++)
+            for(auto& [a, b] : pairs)
+                enemies += Faction::getRelation(a, b) == FactionRelation::Enemy;
+        auto matrix_time = std::chrono::steady_clock::now() - start;
+
+        auto per_pair = [](auto time) { return float(std::chrono::duration<double, std::nano>(time).count() / (rounds * pair_count)); };
+        printf("  linear: %s ns per pair, matrix: %s ns per pair (%d)\n", string(per_pair(linear_time), 1).c_str(), string(per_pair(matrix_time), 1).c_str(), enemies);
+        return true;
+    }
+
+private:
+    // Faction::getRelation as it was before the relation matrix.
+    static FactionRelation linearRelation(sp::ecs::Entity a, sp::ecs::Entity b)
+    {
+        auto fb = b.getComponent<Faction>();
+        auto fia = Faction::getInfo(a);
+        if (fb)
+            return fia.getRelation(fb->entity);
+        return fia.getRelation({});
+    }
+
+    std::vector<sp::ecs::Entity> factions;
+    std::vector<sp::ecs::Entity> ships;
+    std::vector<std::pair<sp::ecs::Entity, sp::ecs::Entity>> pairs;
+};
+
+// Plans routes for ships through fields of asteroids and mines, timed per plan call. Part of the fields is far out
+// and at negative coordinates, where the grid cells of the pathfinding system used to collide. A finished route
+// may not pass any object that a search through all objects finds, which fails when the grid query misses cells.
+class PathPlanCheck : public SelfCheck
+{
+public:
+    static constexpr int object_count = 1000;
+    static constexpr int ship_count = 200;
+    static constexpr int update_rounds = 50;
+    static constexpr float ship_radius = 300.0f;
+    static constexpr float field_size = 40000.0f;
+
+    PathPlanCheck()
+    {
+        for(int n=0; n<object_count; n++)
+        {
+            auto entity = sp::ecs::Entity::create();
+            entity.addComponent<sp::Transform>().setPosition(fieldCenter(n) + glm::vec2(random(-0.5f, 0.5f), random(-0.5f, 0.5f)) * field_size);
+            entity.addComponent<AvoidObject>().range = random(100.0f, 800.0f);
+            objects.push_back(entity);
+        }
+        for(int n=0; n<ship_count; n++)
+        {
+            auto center = fieldCenter(n);
+            ships.push_back({center + glm::vec2(-0.6f, random(-0.5f, 0.5f)) * field_size, center + glm::vec2(0.6f, random(-0.5f, 0.5f)) * field_size, {}});
+        }
+    }
+
+    ~PathPlanCheck()
+    {
+        for(auto entity : objects)
+            entity.destroy();
+    }
+
+    virtual bool run(int tick) override
+    {
+        // The pathfinding system picks up new objects in its update, which runs every tick.
+        if (tick == 0)
+            return false;
+
+        auto start = std::chrono::steady_clock::now();
+        for(auto& ship : ships)
+        {
+            ship.planner.clear();
+            ship.planner.plan(ship_radius, ship.start, ship.end);
+        }
+        auto plan_time = std::chrono::steady_clock::now() - start;
+
+        int blocked = 0;
+        for(auto& ship : ships)
+        {
+            // The planner gives up after 100 detours, then the route can still be blocked.
+            if (ship.planner.route.size() > 100)
+                continue;
+            auto p0 = ship.start;
+            for(auto p1 : ship.planner.route)
+            {
+                if (isBlocked(p0, p1))
+                    blocked++;
+                p0 = p1;
+            }
+        }
+        expect(blocked == 0, string(blocked) + " route segments pass an object");
+
+        // Following a route replans a part of it on every call.
+        start = std::chrono::steady_clock::now();
+        for(int round=0; round<update_rounds; round++)
+            for(auto& ship : ships)
+                ship.planner.plan(ship_radius, ship.start, ship.end);
+        auto update_time = std::chrono::steady_clock::now() - start;
+
+        auto per_call = [](auto time, int calls) { return float(std::chrono::duration<double, std::micro>(time).count() / calls); };
+        printf("  full plan: %s us per ship, route update: %s us per ship\n", string(per_call(plan_time, ship_count), 1).c_str(), string(per_call(update_time, ship_count * update_rounds), 2).c_str());
+        return true;
+    }
+
+private:
+    struct Ship
+    {
+        glm::vec2 start;
+        glm::vec2 end;
+        PathPlanner planner;
+    };
+
+    // Around the origin, far out and far out at negative coordinates.
+    static glm::vec2 fieldCenter(int n)
+    {
+        static const glm::vec2 centers[] = {{0.0f, 0.0f}, {-1000000.0f, -1000000.0f}, {3000000.0f, -2000000.0f}, {-2500000.0f, 1500000.0f}};
+        return centers[n % 4];
+    }
+
+    // The same test as PathPlanner::checkToAvoid, over all objects.
+    bool isBlocked(glm::vec2 start, glm::vec2 end) const
+    {
+        auto diff = end - start;
+        float length = glm::length(diff);
+        if (length < 100.0f)
+            return false;
+        for(auto entity : objects)
+        {
+            auto position = entity.getComponent<sp::Transform>()->getPosition();
+            float range = entity.getComponent<AvoidObject>()->range;
+            float f = glm::dot(diff, position - start) / length;
+            if (f > 0 && f < length - range)
+            {
+                auto q = start + diff / length * f;
+                if (glm::length2(q - position) < (range + ship_radius) * (range + ship_radius))
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<sp::ecs::Entity> objects;
+    std::vector<Ship> ships;
+};
+
+// Loads a stock model the three ways Mesh::loadData can: by parsing the source, from the mesh cache directory,
+// and from a .mesh file shipped in a resource directory, as written by the EmptyEpsilonMeshConverter target.
+// All three have to give the same mesh, and a .mesh file has to read back to exactly what was written.
+class MeshLoadCheck : public SelfCheck
+{
+public:
+    static constexpr int rounds = 10;
+
+    virtual bool run(int tick) override
+    {
+        const string filename = "mesh/ship/Ender Battlecruiser.obj";
+        if (!getResourceStream(filename))
+        {
+            expect(false, filename + " not found");
+            return true;
+        }
+        // The headless server that the benchmark runs as has no cache directory, use a temporary one.
+        auto directory = std::filesystem::temp_directory_path() / "EmptyEpsilonSelfCheck";
+        std::error_code error_code;
+        std::filesystem::remove_all(directory, error_code);
+
+        MeshData source;
+        auto start = std::chrono::steady_clock::now();
+        for(int n=0; n<rounds; n++)
+        {
+            auto stream = getResourceStream(filename);
+            source = MeshData::build(MeshData::parseSource(stream, filename));
+        }
+        auto source_time = std::chrono::steady_clock::now() - start;
+        expect(!source.vertices.empty(), "parsing " + filename + " gave no vertices");
+
+        auto source_key = MeshData::sourceKey(getResourceStream(filename));
+        auto buffer = source.writeBinary(source_key);
+        MeshData round_trip;
+        expect(round_trip.readBinary(buffer.data(), buffer.size(), source_key) && sameMesh(round_trip, source), "readBinary(writeBinary(x)) differs from x");
+        expect(!MeshData().readBinary(buffer.data(), buffer.size(), source_key + 1), "readBinary accepts a mesh of another source");
+        expect(!MeshData().readBinary(buffer.data(), buffer.size() / 2, source_key), "readBinary accepts a truncated mesh");
+
+        // The first load parses the source and fills the cache.
+        Mesh::setCacheDirectory((directory / "meshcache").string());
+        MeshData cached;
+        Mesh::loadData(filename, getResourceStream(filename), NULL, cached);
+        expect(std::filesystem::exists(directory / "meshcache" / (filename.replace("/", "_") + ".mesh")), "no cache file written for " + filename);
+        start = std::chrono::steady_clock::now();
+        for(int n=0; n<rounds; n++)
+            Mesh::loadData(filename, getResourceStream(filename), NULL, cached);
+        auto cache_time = std::chrono::steady_clock::now() - start;
+        expect(sameMesh(cached, source), "mesh from the cache differs from the parsed mesh");
+
+        auto shipped_filename = directory / "resources" / (filename + ".mesh");
+        std::filesystem::create_directories(shipped_filename.parent_path(), error_code);
+        if (FILE* f = fopen(shipped_filename.string().c_str(), "wb"))
+        {
+            fwrite(buffer.data(), 1, buffer.size(), f);
+            fclose(f);
+        }
+        new DirectoryResourceProvider((directory / "resources").string() + "/");
+        expect(bool(getResourceStream(filename + ".mesh")), filename + ".mesh not found after writing it");
+        MeshData shipped;
+        start = std::chrono::steady_clock::now();
+        for(int n=0; n<rounds; n++)
+            Mesh::loadData(filename, getResourceStream(filename), getResourceStream(filename + ".mesh"), shipped);
+        auto shipped_time = std::chrono::steady_clock::now() - start;
+        expect(sameMesh(shipped, source), "mesh from the shipped .mesh file differs from the parsed mesh");
+
+        auto per_load = [](auto time) { return float(std::chrono::duration<double, std::milli>(time).count() / rounds); };
+        printf("  %s, %d vertices: source %s ms, cache %s ms, shipped %s ms\n", filename.c_str(), int(source.vertices.size()),
+            string(per_load(source_time), 2).c_str(), string(per_load(cache_time), 2).c_str(), string(per_load(shipped_time), 2).c_str());
+        return true;
+    }
+
+private:
+    static bool sameMesh(const MeshData& a, const MeshData& b)
+    {
+        return a.vertices.size() == b.vertices.size()
+            && memcmp(a.vertices.data(), b.vertices.data(), a.vertices.size() * sizeof(MeshVertex)) == 0
+            && a.indices == b.indices
+            && a.greatest_distance_from_center == b.greatest_distance_from_center;
+    }
+};
+
+// Receives what the sACN output broadcasts, on the local machine, and checks the bytes that are patched on
+// every send: the sequence numbers (offset 111 in data packets, 44 in synchronization packets) and the
+// slot data (from offset 126).
+class AcnLoopbackCheck : public SelfCheck
+{
+public:
+    static constexpr int acn_port = 5568;
+    static constexpr int first_universe = 7;
+    static constexpr int sync_universe = 9;
+
+    AcnLoopbackCheck()
+    {
+        bound = receiver.bind(acn_port);
+        receiver.setBlocking(false);
+        // Bound first, so the packets sent as soon as the device is configured are received as well.
+        device.configure({{"channels", "600"}, {"universe", string(first_universe)}, {"sync_universe", string(sync_universe)}, {"resend_delay", "50"}});
+        device.setChannelData(0, 1.0f);
+        device.setChannelData(599, 0.5f);
+        start = std::chrono::steady_clock::now();
+    }
+
+    virtual bool run(int tick) override
+    {
+        if (!bound)
+        {
+            expect(false, "could not bind port " + string(acn_port));
+            return true;
+        }
+
+        uint8_t buffer[1024];
+        sp::io::network::Address address;
+        int port;
+        while(true)
+        {
+            auto size = receiver.receive(buffer, sizeof(buffer), address, port);
+            if (size == 0)
+                break;
+            if (size == 49 && readU16(buffer + 45) == sync_universe)
+            {
+                checkSequence(sync_sequence, buffer[44], "synchronization");
+                sync_packets++;
+            }
+            else if (size >= 126 && (readU16(buffer + 113) == first_universe || readU16(buffer + 113) == first_universe + 1))
+                checkData(buffer, size);
+        }
+
+        // A few keep alive rounds.
+        if (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(500))
+            return false;
+        expect(data_packets[0] > 1 && data_packets[1] > 1, "received " + string(data_packets[0]) + " and " + string(data_packets[1]) + " data packets");
+        expect(sync_packets > 1, "received " + string(sync_packets) + " synchronization packets");
+        expect(first_slot_set, "channel 0 was not sent as 255 at offset 126");
+        expect(last_slot_set, "channel 599 was not sent as 128 at offset 126 + 87");
+
+        StreamingAcnDMXDevice capped;
+        capped.configure({{"channels", "1000000"}, {"universe", "100"}});
+        expect(capped.getChannelCount() == 64 * 512, "1000000 channels are capped at " + string(capped.getChannelCount()));
+        return true;
+    }
+
+private:
+    static int readU16(const uint8_t* data) { return (data[0] << 8) | data[1]; }
+
+    void checkSequence(int& last, uint8_t sequence, const char* name)
+    {
+        if (last >= 0)
+            expect(sequence == uint8_t(last + 1), string(name) + " sequence number went from " + string(last) + " to " + string(int(sequence)));
+        last = sequence;
+    }
+
+    void checkData(const uint8_t* buffer, size_t size)
+    {
+        int index = readU16(buffer + 113) - first_universe;
+        int expected_size = 126 + (index == 0 ? 512 : 600 - 512);
+        expect(int(size) == expected_size, "universe " + string(first_universe + index) + " packet is " + string(int(size)) + " bytes");
+        checkSequence(sequence[index], buffer[111], "data");
+        data_packets[index]++;
+        if (index == 0 && buffer[126] == 255)
+            first_slot_set = true;
+        if (index == 1 && int(size) == expected_size && buffer[126 + 87] == 128)
+            last_slot_set = true;
+    }
+
+    sp::io::network::UdpSocket receiver;
+    bool bound = false;
+    StreamingAcnDMXDevice device;
+    std::chrono::steady_clock::time_point start;
+    int sequence[2] = {-1, -1};
+    int sync_sequence = -1;
+    int data_packets[2] = {0, 0};
+    int sync_packets = 0;
+    bool first_slot_set = false;
+    bool last_slot_set = false;
+};
+
+#ifdef __gnu_linux__
+// Runs the Philips Hue output against a bridge served from this process. First against a bridge without an
+// EmptyEpsilon group, which has to be created, then against one that has it among other groups. Group 0, all
+// lights of the bridge, may never be touched. While all lights are set to the same changing state, the group is
+// set at most once per second, once the lights differ it is not set at all, and all requests stay within
+// requests_per_second.
+class HueBridgeCheck : public SelfCheck
+{
+public:
+    static constexpr int bridge_port = 32280;
+    static constexpr int light_count = 4;
+    static constexpr int requests_per_second = 10;
+
+    HueBridgeCheck()
+    : server(bridge_port)
+    {
+        const string api = "/api/selfcheck";
+        server.addURLHandler(api + "/lights", [this](const sp::io::http::Server::Request& request) -> string
+        {
+            record(request);
+            string result = "{";
+            for(int n=1; n<=light_count; n++)
+                result += string(n > 1 ? "," : "") + "\"" + string(n) + "\": {\"name\": \"Light " + string(n) + "\"}";
+            return result + "}";
+        });
+        server.addURLHandler(api + "/groups", [this](const sp::io::http::Server::Request& request) -> string
+        {
+            record(request);
+            if (string(request.method).upper() == "POST")
+                return "[{\"success\":{\"id\":\"7\"}}]";
+            if (bridge_has_group)
+                return "{\"1\": {\"name\": \"Living room\"}, \"3\": {\"name\": \"EmptyEpsilon\"}}";
+            return "{\"1\": {\"name\": \"Living room\"}}";
+        });
+        for(string group : {"0", "1", "3", "7"})
+        {
+            server.addURLHandler(api + "/groups/" + group, [this](const sp::io::http::Server::Request& request) -> string { record(request); return "[]"; });
+            server.addURLHandler(api + "/groups/" + group + "/action", [this](const sp::io::http::Server::Request& request) -> string { record(request); return "[]"; });
+        }
+        for(int n=1; n<=light_count; n++)
+            server.addURLHandler(api + "/lights/" + string(n) + "/state", [this](const sp::io::http::Server::Request& request) -> string { record(request); return "[]"; });
+    }
+
+    virtual bool run(int tick) override
+    {
+        auto now = std::chrono::steady_clock::now();
+        if (tick == 0)
+        {
+            device = std::make_unique<PhilipsHueDevice>();
+            expect(device->configure(settings()), "configuring against a bridge without the group failed");
+            // The first update sends the initial state of all lights to the group.
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            device.reset();
+            expect(count("POST", "/groups") == 1, "the EmptyEpsilon group was not created");
+            expect(count("PUT", "/groups/7/action") == 1, "the created group 7 was not used");
+            checkGroupZero();
+
+            clearReceived();
+            bridge_has_group = true;
+            device = std::make_unique<PhilipsHueDevice>();
+            expect(device->configure(settings()), "configuring against a bridge with the group failed");
+            start = now;
+            return false;
+        }
+
+        // Steps of 300ms, first every light the same like a flashing alert, then every light different.
+        int step = int(std::chrono::duration<float>(now - start).count() / 0.3f);
+        bool same = now - start < std::chrono::milliseconds(2500);
+        if (!same && different_start == std::chrono::steady_clock::time_point{})
+            different_start = now;
+        if (now - start < std::chrono::milliseconds(4000))
+        {
+            for(int n=0; n<light_count; n++)
+            {
+                device->setChannelData(n * 4 + 0, 1.0f);
+                device->setChannelData(n * 4 + 1, 1.0f);
+                device->setChannelData(n * 4 + 2, float((step + (same ? 0 : n)) % 8) / 8.0f);
+                device->setChannelData(n * 4 + 3, 0.0f);
+            }
+            return false;
+        }
+        device.reset();
+
+        expect(count("PUT", "/groups/3") == 1, "the lights of the existing group 3 were not updated");
+        expect(count("POST", "/groups") == 0, "a group was created while the bridge has one");
+        checkGroupZero();
+
+        std::vector<Received> updates;
+        std::vector<std::chrono::steady_clock::time_point> actions;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for(auto& r : received)
+            {
+                if (r.path.endswith("/state") || r.path.endswith("/action"))
+                    updates.push_back(r);
+                if (r.path.endswith("/action"))
+                {
+                    expect(r.path.endswith("/groups/3/action"), "group action sent to " + r.path);
+                    actions.push_back(r.time);
+                }
+            }
+        }
+        // Timestamps are taken when the server handles the request, a delayed request can bring the next one closer.
+        size_t most_in_a_second = 0;
+        for(size_t n=0; n<updates.size(); n++)
+        {
+            size_t end = n;
+            while(end < updates.size() && updates[end].time - updates[n].time < std::chrono::seconds(1))
+                end++;
+            most_in_a_second = std::max(most_in_a_second, end - n);
+        }
+        expect(most_in_a_second <= requests_per_second + 1, string(int(most_in_a_second)) + " requests within a second");
+        expect(actions.size() >= 2, "only " + string(int(actions.size())) + " group actions while all lights were the same");
+        for(size_t n=1; n<actions.size(); n++)
+            expect(actions[n] - actions[n - 1] > std::chrono::milliseconds(950), "two group actions within a second");
+        for(auto time : actions)
+            expect(time < different_start + std::chrono::milliseconds(200), "group action while the lights differ");
+        printf("  %d requests, %d group actions, at most %d requests in a second\n", int(updates.size()), int(actions.size()), int(most_in_a_second));
+        return true;
+    }
+
+private:
+    struct Received
+    {
+        std::chrono::steady_clock::time_point time;
+        string method;
+        string path;
+    };
+
+    static std::unordered_map<string, string> settings()
+    {
+        return {{"ip", "127.0.0.1"}, {"port", string(bridge_port)}, {"username", "selfcheck"}, {"requests_per_second", string(requests_per_second)}};
+    }
+
+    void record(const sp::io::http::Server::Request& request)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        received.push_back({std::chrono::steady_clock::now(), string(request.method).upper(), request.path});
+    }
+
+    void clearReceived()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        received.clear();
+    }
+
+    int count(const string& method, const string& path_end)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return std::count_if(received.begin(), received.end(), [&](const Received& r) { return r.method == method && r.path.endswith(path_end); });
+    }
+
+    void checkGroupZero()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for(auto& r : received)
+            expect(!r.path.endswith("/groups/0") && !r.path.endswith("/groups/0/action"), "group 0 used: " + r.method + " " + r.path);
+    }
+
+    std::mutex mutex;
+    std::vector<Received> received;
+    std::atomic<bool> bridge_has_group{false};
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point different_start;
+    // Last, so the device and then the server stop before what they record into goes away.
+    sp::io::http::Server server;
+    std::unique_ptr<PhilipsHueDevice> device;
+};
+
+// Runs a DMX style output, with a break before every frame, through the serial frame scheduler into a pseudo
+// terminal, and reads the other end. Every frame has to arrive whole and in order: start code 0 followed by
+// 512 slots of the frame number. A pty has no break or output queue, so this covers the scheduling, not the timing on the line.
+class SerialPtyCheck : public SelfCheck
+{
+public:
+    static constexpr int frame_size = 513;
+
+    SerialPtyCheck()
+    {
+        master = posix_openpt(O_RDWR | O_NOCTTY);
+        if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0)
+            return;
+        fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+        port = std::make_unique<SerialPort>(string(ptsname(master)));
+        port->configure(250000, 8, SerialPort::NoParity, SerialPort::TwoStopbits);
+        SerialFrameScheduler::add(port.get(), [this](std::vector<uint8_t>& frame)
+        {
+            frame.assign(frame_size, uint8_t(++frames_built));
+            frame[0] = 0;
+            return true;
+        }, std::chrono::milliseconds(10), std::chrono::milliseconds(1000), true);
+        start = std::chrono::steady_clock::now();
+    }
+
+    ~SerialPtyCheck()
+    {
+        if (port)
+            SerialFrameScheduler::remove(port.get());
+        port.reset();
+        if (master >= 0)
+            close(master);
+    }
+
+    virtual bool run(int tick) override
+    {
+        if (!port)
+        {
+            expect(false, "could not open a pseudo terminal");
+            return true;
+        }
+
+        uint8_t buffer[4096];
+        while(true)
+        {
+            auto size = read(master, buffer, sizeof(buffer));
+            if (size <= 0)
+                break;
+            received.insert(received.end(), buffer, buffer + size);
+        }
+        size_t offset = 0;
+        for(; offset + frame_size <= received.size(); offset += frame_size)
+        {
+            uint8_t number = received[offset + 1];
+            bool whole = received[offset] == 0 && std::all_of(received.begin() + offset + 1, received.begin() + offset + frame_size, [number](uint8_t v) { return v == number; });
+            if (!whole)
+            {
+                expect(false, "frame " + string(frames_received) + " is cut off or mixed with the next one");
+                return true;
+            }
+            if (frames_received > 0)
+                expect(number == uint8_t(last_number + 1), "frame " + string(int(number)) + " follows frame " + string(int(last_number)));
+            last_number = number;
+            frames_received++;
+        }
+        received.erase(received.begin(), received.begin() + offset);
+
+        if (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(500))
+            return false;
+        // 50 frames at 10ms, but leave room for a busy machine.
+        expect(frames_received >= 20, "received " + string(frames_received) + " frames in 500ms");
+        return true;
+    }
+
+private:
+    int master = -1;
+    std::unique_ptr<SerialPort> port;
+    std::atomic<int> frames_built{0};
+    std::chrono::steady_clock::time_point start;
+    std::vector<uint8_t> received;
+    int frames_received = 0;
+    uint8_t last_number = 0;
+};
+#endif
+
+class SelfCheckRunner : public Updatable
+{
+public:
+    struct Entry
+    {
+        const char* name;
+        std::unique_ptr<SelfCheck> (*create)();
+    };
+
+    explicit SelfCheckRunner(std::vector<Entry> checks)
+    : checks(std::move(checks))
+    {
+    }
+
+    virtual void update(float delta) override
+    {
+        if (index < checks.size())
+        {
+            if (!current)
+            {
+                printf("%s\n", checks[index].name);
+                fflush(stdout);
+                current = checks[index].create();
+                tick = 0;
+            }
+            if (current->run(tick++))
+            {
+                current.reset();
+                index++;
+            }
+            return;
+        }
+
+        printf("%d self check failures\n", failures);
+        fflush(stdout);
+        if (failures > 0)
+            exit(1);
+        engine->shutdown();
+    }
+
+private:
+    std::vector<Entry> checks;
+    size_t index = 0;
+    int tick = 0;
+    std::unique_ptr<SelfCheck> current;
+};
+
+template<typename T> static std::unique_ptr<SelfCheck> create() { return std::make_unique<T>(); }
+
+void setupSelfCheck()
+{
+    new SelfCheckRunner({
+        {"replication allocations", create<ReplicationAllocationCheck>},
+        {"wire encoding round trips", create<WireEncodingCheck>},
+        {"replication packet size", create<PacketSizeCheck>},
+        {"ship system table", create<ShipSystemTableCheck>},
+        {"faction relations", create<FactionRelationCheck>},
+        {"path planning", create<PathPlanCheck>},
+        {"mesh loading", create<MeshLoadCheck>},
+        {"sACN loopback", create<AcnLoopbackCheck>},
+        {"Hue bridge", create<HueBridgeCheck>},
+#ifdef __gnu_linux__
+        {"serial frames through a pty", create<SerialPtyCheck>},
+#endif
+    });
+}